@@ -15,8 +15,10 @@ make
 /usr/bin/valgrind valgrind --error-exitcode=123 --leak-check=full ./tests/pageRankCalculationTest
 
 ./tests/sha256Test
+./tests/cachingIdGeneratorTest
 ./tests/pageRankCalculationTest
 ./tests/pageRankPerformanceTest
+./tests/pageRankTaskTest
 
 ./tests/e2eTest < ./tests/e2eScenario.txt
 for i in 1 2 7; do ./tests/e2eTest $i < ./tests/e2eScenario.txt; done
@@ -27,8 +29,21 @@ cmake -DCMAKE_BUILD_TYPE=Release .
 make
 
 ./tests/sha256Test
+./tests/cachingIdGeneratorTest
 ./tests/pageRankCalculationTest
 ./tests/pageRankPerformanceTest
+./tests/pageRankTaskTest
+./tests/pageRankBenchmark --sizes=1000 --threads=1,4 --trials=3 --output=benchmark.csv
+./tests/pageRankBenchmark --compare=benchmark.csv,benchmark.csv
+./tests/pageRankBenchmark --versus=multi-two-pass,multi --families=sparse,rmat,hosts --sizes=20000,200000 --threads=4 --max-difference=0.0000001
 
 ./tests/e2eTest < ./tests/e2eScenario.txt
 for i in 1 2 3 4 8; do ./tests/e2eTest $i < ./tests/e2eScenario.txt; done
+
+# With PAGERANK_E2E_TIMING set, the runs above also time their first iteration, and two
+# more runs exercise the id cache: the second one is served from what the first one wrote
+if [ -n "$PAGERANK_E2E_TIMING" ]; then
+    rm -f ./e2eIdCache.txt
+    for i in 1 2; do ./tests/e2eTest 4 ./e2eIdCache.txt < ./tests/e2eScenario.txt; done
+    rm -f ./e2eIdCache.txt
+fi
@@ -0,0 +1,95 @@
+#ifndef SRC_ARENA_HPP_
+#define SRC_ARENA_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct ArenaStats {
+    size_t numChunks;
+    // Bytes handed out, without alignment padding and unused chunk tails
+    size_t bytesUsed;
+    size_t bytesReserved;
+};
+
+// Bump allocator: memory is carved sequentially out of big chunks and is only
+// freed all at once, when the arena is destroyed. Objects placed in the arena
+// are never destructed, so it is meant for characters and other trivial types.
+class Arena {
+public:
+    Arena(size_t chunkSizeArg = DEFAULT_CHUNK_SIZE)
+        : chunkSize(chunkSizeArg)
+        , position(nullptr)
+        , end(nullptr)
+        , bytesUsed(0)
+        , bytesReserved(0)
+    {
+    }
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    char* allocate(size_t size, size_t alignment = 1)
+    {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(this->position) % alignment) % alignment;
+        if (this->position == nullptr or padding + size > static_cast<size_t>(this->end - this->position)) {
+            // Allocations bigger than a quarter of a chunk get a block of their own, the current chunk stays open
+            if (size + alignment > this->chunkSize / 4) {
+                this->bytesUsed += size;
+                return this->allocateChunk(size); // new[] aligns for any fundamental type
+            }
+            this->position = this->allocateChunk(this->chunkSize);
+            this->end = this->position + this->chunkSize;
+            padding = (alignment - reinterpret_cast<uintptr_t>(this->position) % alignment) % alignment;
+        }
+
+        char* result = this->position + padding;
+        this->position = result + size;
+        this->bytesUsed += size;
+        return result;
+    }
+
+    template <typename T>
+    T* allocateArray(size_t size)
+    {
+        return reinterpret_cast<T*>(this->allocate(size * sizeof(T), alignof(T)));
+    }
+
+    std::string_view copy(std::string_view str)
+    {
+        if (str.empty()) {
+            return std::string_view();
+        }
+        char* data = this->allocate(str.size());
+        std::memcpy(data, str.data(), str.size());
+        return std::string_view(data, str.size());
+    }
+
+    ArenaStats getStats() const
+    {
+        return ArenaStats { this->chunks.size(), this->bytesUsed, this->bytesReserved };
+    }
+
+private:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+    char* allocateChunk(size_t size)
+    {
+        this->chunks.emplace_back(new char[size]);
+        this->bytesReserved += size;
+        return this->chunks.back().get();
+    }
+
+    size_t chunkSize;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* position;
+    char* end;
+    size_t bytesUsed;
+    size_t bytesReserved;
+};
+
+#endif /* SRC_ARENA_HPP_ */
@@ -0,0 +1,164 @@
+#ifndef SRC_ARENANETWORK_HPP_
+#define SRC_ARENANETWORK_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "immutable/idGenerator.hpp"
+#include "immutable/page.hpp"
+#include "arena.hpp"
+
+// Compact alternative to Network for big inputs: contents and link ids of all pages
+// live in a single arena, so loading a page costs no allocation of its own and the
+// whole network is freed at once. Equal link ids share their characters. Links of all
+// pages are stored contiguously, links of page p are
+// getLink(p, 0) .. getLink(p, getNumLinks(p) - 1).
+// Built with ArenaNetworkBuilder, read-only afterwards.
+class ArenaNetwork {
+public:
+    ArenaNetwork(ArenaNetwork&&) = default;
+
+    size_t getSize() const
+    {
+        return this->contents.size();
+    }
+
+    std::string_view getContent(size_t page) const
+    {
+        return this->contents[page];
+    }
+
+    size_t getNumLinks(size_t page) const
+    {
+        return this->linkOffsets[page + 1] - this->linkOffsets[page];
+    }
+
+    std::string_view getLink(size_t page, size_t link) const
+    {
+        return this->links[this->linkOffsets[page] + link];
+    }
+
+    size_t getTotalNumLinks() const
+    {
+        return this->links.size();
+    }
+
+    IdGenerator const& getGenerator() const
+    {
+        return this->idGenerator;
+    }
+
+    ArenaStats getArenaStats() const
+    {
+        return this->arena.getStats();
+    }
+
+private:
+    friend class ArenaNetworkBuilder;
+
+    ArenaNetwork(IdGenerator const& idGeneratorArg)
+        : linkOffsets(1, 0)
+        , idGenerator(idGeneratorArg)
+    {
+    }
+
+    Arena arena;
+    std::vector<std::string_view> contents;
+    std::vector<size_t> linkOffsets;
+    std::vector<std::string_view> links;
+    IdGenerator const& idGenerator;
+};
+
+// Pages are added either whole, or started by their content and followed by their links
+class ArenaNetworkBuilder {
+public:
+    ArenaNetworkBuilder(IdGenerator const& idGeneratorArg)
+        : network(idGeneratorArg)
+        , numInterned(0)
+    {
+    }
+
+    // Avoids regrowing the page and link arrays when the sizes are known upfront
+    void reserve(size_t numPages, size_t numLinks)
+    {
+        this->network.contents.reserve(numPages);
+        this->network.linkOffsets.reserve(numPages + 1);
+        this->network.links.reserve(numLinks);
+    }
+
+    void startPage(std::string_view content)
+    {
+        this->network.contents.push_back(this->network.arena.copy(content));
+        this->network.linkOffsets.push_back(this->network.links.size());
+    }
+
+    // Adds a link to the most recently added page
+    void addLink(std::string_view link)
+    {
+        ASSERT(not this->network.contents.empty(), "Adding link before any page");
+        this->network.links.push_back(this->intern(link));
+        ++this->network.linkOffsets.back();
+    }
+
+    // Takes over a page built the usual way, its strings are freed as soon as it is copied in
+    void addPage(Page&& page)
+    {
+        Page consumed(std::move(page));
+        this->startPage(consumed.getContent());
+        for (auto const& link : consumed.getLinks()) {
+            this->addLink(link.getView());
+        }
+    }
+
+    // The builder must not be used afterwards
+    ArenaNetwork build()
+    {
+        return std::move(this->network);
+    }
+
+private:
+    // Every distinct link id is copied into the arena only once. The table is open
+    // addressed with linear probing, so it does not allocate per entry either.
+    std::string_view intern(std::string_view link)
+    {
+        if (link.empty()) {
+            return std::string_view();
+        }
+        if (2 * (this->numInterned + 1) > this->internTable.size()) {
+            std::vector<std::string_view> oldTable(std::max<size_t>(2 * this->internTable.size(), 1024));
+            oldTable.swap(this->internTable);
+            for (auto const& interned : oldTable) {
+                if (interned.data() != nullptr) {
+                    this->internTable[this->findSlot(interned)] = interned;
+                }
+            }
+        }
+
+        std::string_view& slot = this->internTable[this->findSlot(link)];
+        if (slot.data() == nullptr) {
+            slot = this->network.arena.copy(link);
+            ++this->numInterned;
+        }
+        return slot;
+    }
+
+    // Slot holding link, or the empty slot where it belongs
+    size_t findSlot(std::string_view link) const
+    {
+        size_t mask = this->internTable.size() - 1;
+        size_t slot = std::hash<std::string_view> {}(link) & mask;
+        while (this->internTable[slot].data() != nullptr and this->internTable[slot] != link) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    ArenaNetwork network;
+    std::vector<std::string_view> internTable;
+    size_t numInterned;
+};
+
+#endif /* SRC_ARENANETWORK_HPP_ */
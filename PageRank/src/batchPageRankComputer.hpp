@@ -0,0 +1,220 @@
+#ifndef SRC_BATCHPAGERANKCOMPUTER_HPP_
+#define SRC_BATCHPAGERANKCOMPUTER_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "compiledNetwork.hpp"
+#include "pageRankControl.hpp"
+#include "pageRankIteration.hpp"
+#include "pageRankKernel.hpp"
+
+// Throughput mode for many small networks. For a network of a few hundred pages,
+// forking threads costs more than the computation itself, so this computer keeps a
+// pool of workers for its whole life instead, hands out whole networks to them one by
+// one, and every worker computes its networks alone. Workers keep their buffers from
+// network to network, so a batch allocates little more than its results.
+// Ranks are the same as those of MultiThreadedPageRankComputer with a single thread.
+// Batches are not instrumented, the observer is ignored.
+class BatchPageRankComputer : public PageRankComputer, public PageRankControllable {
+public:
+    BatchPageRankComputer(uint32_t numThreadsArg)
+        : numThreads(numThreadsArg)
+        , batch(nullptr)
+        , batchNumber(0)
+        , numBusyWorkers(0)
+        , stopping(false)
+    {
+        for (uint32_t t = 0; t < this->numThreads; ++t) {
+            this->workers.push_back(std::thread { [this] { this->work(); } });
+        }
+    }
+
+    BatchPageRankComputer(BatchPageRankComputer const&) = delete;
+    BatchPageRankComputer& operator=(BatchPageRankComputer const&) = delete;
+
+    ~BatchPageRankComputer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->batchStarted.notify_all();
+        for (auto& worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations,
+        double tolerance) const
+    {
+        PageRankResult result = this->computeWithControl(network, alpha, iterations, tolerance, nullptr);
+        ASSERT(result.converged, "Not able to find result in iterations=" << iterations);
+        return std::move(result.ranks);
+    }
+
+    // A batch of one network, computed by one of the workers
+    PageRankResult computeWithControl(Network const& network, double alpha, uint32_t iterations,
+        double tolerance, PageRankControl* control) const
+    {
+        return std::move(this->computeBatch({ &network }, alpha, iterations, tolerance, control)[0]);
+    }
+
+    // Results are in the order of networks. Networks which do not converge in iterations
+    // get what they reached, like from computeWithControl.
+    std::vector<PageRankResult> computeForNetworks(std::vector<Network> const& networks, double alpha,
+        uint32_t iterations, double tolerance) const
+    {
+        std::vector<Network const*> batchNetworks;
+        batchNetworks.reserve(networks.size());
+        for (auto const& network : networks) {
+            batchNetworks.push_back(&network);
+        }
+        return this->computeBatch(batchNetworks, alpha, iterations, tolerance, nullptr);
+    }
+
+    std::string getName() const
+    {
+        return "BatchPageRankComputer[" + std::to_string(this->numThreads) + "]";
+    }
+
+private:
+    struct Batch {
+        std::vector<Network const*> const& networks;
+        double alpha;
+        uint32_t iterations;
+        double tolerance;
+        PageRankControl* control;
+        std::vector<PageRankResult>& results;
+        std::atomic<size_t> nextNetwork;
+    };
+
+    // Everything a worker needs for a network, kept between networks
+    struct Scratch {
+        Scratch()
+            : measurements(1)
+        {
+        }
+
+        CompiledNetwork<uint32_t> compiled;
+        CompileScratch<uint32_t> compileScratch;
+        std::vector<WorkMeasurement> measurements;
+        std::vector<double> ranks;
+        std::vector<double> previousContributions;
+        std::vector<double> nextContributions;
+    };
+
+    // Batches run one at a time, callers from other threads wait for their turn.
+    // Only a batch of a single network may be followed by a control.
+    std::vector<PageRankResult> computeBatch(std::vector<Network const*> const& networks, double alpha,
+        uint32_t iterations, double tolerance, PageRankControl* control) const
+    {
+        ASSERT(control == nullptr or networks.size() == 1, "Control of a batch of networks=" << networks.size());
+        std::vector<PageRankResult> results(networks.size());
+        Batch currentBatch { networks, alpha, iterations, tolerance, control, results, { 0 } };
+
+        std::lock_guard<std::mutex> batchLock(this->batchMutex);
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->batch = &currentBatch;
+        ++this->batchNumber;
+        this->numBusyWorkers = this->numThreads;
+        this->batchStarted.notify_all();
+        this->batchFinished.wait(lock, [this] { return this->numBusyWorkers == 0; });
+        this->batch = nullptr;
+        return results;
+    }
+
+    void work() const
+    {
+        Scratch scratch;
+        uint64_t lastBatchNumber = 0;
+        while (true) {
+            Batch* currentBatch;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->batchStarted.wait(lock, [&] { return this->stopping or this->batchNumber != lastBatchNumber; });
+                if (this->stopping) {
+                    return;
+                }
+                lastBatchNumber = this->batchNumber;
+                currentBatch = this->batch;
+            }
+
+            for (size_t i = currentBatch->nextNetwork++; i < currentBatch->networks.size(); i = currentBatch->nextNetwork++) {
+                currentBatch->results[i] = computeNetwork(*currentBatch->networks[i], currentBatch->alpha,
+                    currentBatch->iterations, currentBatch->tolerance, currentBatch->control, scratch);
+            }
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (--this->numBusyWorkers == 0) {
+                this->batchFinished.notify_all();
+            }
+        }
+    }
+
+    static PageRankResult computeNetwork(Network const& network, double alpha, uint32_t iterations,
+        double tolerance, PageRankControl* control, Scratch& scratch)
+    {
+        std::vector<PageId> ids;
+        ids.reserve(network.getSize());
+        size_t numLinks = 0;
+        for (auto const& page : network.getPages()) {
+            if (not page.isIdGenerated()) {
+                page.generateId(network.getGenerator());
+            }
+            ids.push_back(page.getId());
+            numLinks += page.getLinks().size();
+        }
+        ASSERT(CompiledNetwork<uint32_t>::canIndex(ids.size(), numLinks),
+            "Network too big for a batch, size=" << ids.size() << ", links=" << numLinks);
+        CompiledNetwork<uint32_t>::compileInto(scratch.compiled, scratch.compileScratch, std::move(ids),
+            NetworkLinks(network), 1, scratch.measurements, false, false);
+
+        bool hasDanglingNodes = scratch.compiled.hasDanglingVertices();
+        bool unweighted = not scratch.compiled.isWeighted();
+        if (hasDanglingNodes) {
+            return unweighted ? iterate<true, true>(alpha, iterations, tolerance, control, scratch)
+                              : iterate<true, false>(alpha, iterations, tolerance, control, scratch);
+        }
+        return unweighted ? iterate<false, true>(alpha, iterations, tolerance, control, scratch)
+                          : iterate<false, false>(alpha, iterations, tolerance, control, scratch);
+    }
+
+    // Fused iteration of MultiThreadedPageRankComputer over the whole core at once
+    template <bool HasDanglingNodes, bool Unweighted>
+    static PageRankResult iterate(double alpha, uint32_t iterations, double tolerance, PageRankControl* control,
+        Scratch& scratch)
+    {
+        uint32_t numCoreVertices = scratch.compiled.getNumCoreVertices();
+        PageRankIteration<double, uint32_t, HasDanglingNodes, Unweighted> iteration(scratch.compiled, alpha,
+            scratch.ranks, scratch.previousContributions, scratch.nextContributions);
+        std::vector<SweepResult> sweepResults(1);
+        while (iteration.shouldContinue(iterations, control)) {
+            double baseValue = iteration.getBaseValue();
+            sweepResults[0] = iteration.sweep(0, numCoreVertices, baseValue);
+            iteration.finish(baseValue, sweepResults, tolerance, control);
+        }
+        return iteration.getResult(control);
+    }
+
+    uint32_t numThreads;
+    std::vector<std::thread> workers;
+
+    mutable std::mutex batchMutex;
+    mutable std::mutex mutex;
+    mutable std::condition_variable batchStarted;
+    mutable std::condition_variable batchFinished;
+    // Guarded by mutex
+    mutable Batch* batch;
+    mutable uint64_t batchNumber;
+    mutable uint32_t numBusyWorkers;
+    bool stopping;
+};
+
+#endif /* SRC_BATCHPAGERANKCOMPUTER_HPP_ */
@@ -0,0 +1,285 @@
+#ifndef SRC_CACHINGIDGENERATOR_HPP_
+#define SRC_CACHINGIDGENERATOR_HPP_
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "immutable/common.hpp"
+#include "immutable/idGenerator.hpp"
+#include "immutable/pageId.hpp"
+
+// 64-bit xxHash (XXH64) of the content, https://github.com/Cyan4973/xxHash
+// Assumes a little-endian host.
+class XxHash64 {
+public:
+    static uint64_t hash(char const* data, size_t length, uint64_t seed = 0)
+    {
+        char const* end = data + length;
+        uint64_t result;
+
+        if (length >= 32) {
+            uint64_t v1 = seed + PRIME1 + PRIME2;
+            uint64_t v2 = seed + PRIME2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - PRIME1;
+            for (; data + 32 <= end; data += 32) {
+                v1 = round(v1, read64(data));
+                v2 = round(v2, read64(data + 8));
+                v3 = round(v3, read64(data + 16));
+                v4 = round(v4, read64(data + 24));
+            }
+            result = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+            result = mergeRound(result, v1);
+            result = mergeRound(result, v2);
+            result = mergeRound(result, v3);
+            result = mergeRound(result, v4);
+        } else {
+            result = seed + PRIME5;
+        }
+
+        result += length;
+
+        for (; data + 8 <= end; data += 8) {
+            result ^= round(0, read64(data));
+            result = rotateLeft(result, 27) * PRIME1 + PRIME4;
+        }
+        if (data + 4 <= end) {
+            result ^= read32(data) * PRIME1;
+            result = rotateLeft(result, 23) * PRIME2 + PRIME3;
+            data += 4;
+        }
+        for (; data < end; ++data) {
+            result ^= static_cast<uint8_t>(*data) * PRIME5;
+            result = rotateLeft(result, 11) * PRIME1;
+        }
+
+        result ^= result >> 33;
+        result *= PRIME2;
+        result ^= result >> 29;
+        result *= PRIME3;
+        result ^= result >> 32;
+        return result;
+    }
+
+private:
+    static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    static uint64_t rotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static uint64_t read64(char const* data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint64_t read32(char const* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint64_t round(uint64_t accumulator, uint64_t input)
+    {
+        accumulator += input * PRIME2;
+        accumulator = rotateLeft(accumulator, 31);
+        return accumulator * PRIME1;
+    }
+
+    static uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+    {
+        accumulator ^= round(0, value);
+        return accumulator * PRIME1 + PRIME4;
+    }
+};
+
+struct ContentFingerprint {
+    uint64_t hash;
+    uint64_t length;
+
+    bool operator==(ContentFingerprint const& other) const
+    {
+        return this->hash == other.hash and this->length == other.length;
+    }
+};
+
+class ContentFingerprintHash {
+public:
+    std::size_t operator()(ContentFingerprint const& fingerprint) const
+    {
+        return fingerprint.hash ^ (fingerprint.length * 0x9E3779B97F4A7C15ULL);
+    }
+};
+
+struct IdCacheStats {
+    size_t numHits;
+    size_t numMisses;
+    size_t numEntries;
+
+    double getHitRate() const
+    {
+        return this->numHits + this->numMisses == 0 ? 0.0 : static_cast<double>(this->numHits) / (this->numHits + this->numMisses);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, IdCacheStats const& stats)
+{
+    out << "hits=" << stats.numHits << ", misses=" << stats.numMisses
+        << ", hitRate=" << stats.getHitRate() << ", entries=" << stats.numEntries;
+    return out;
+}
+
+// IdGenerator decorator remembering ids generated by the wrapped generator.
+// Entries are keyed by a cheap fingerprint of the content (xxHash64 and length),
+// so pages whose content did not change skip the expensive generator entirely.
+// The cache is loaded from cacheFilename (if it exists) on construction and
+// written back by save(), which makes it persistent across runs. save() keeps only
+// entries looked up since then, so pages that left the network (e.g. of a daily
+// crawl) leave the file as well. The file starts with generatorTag, naming the
+// wrapped generator: a file of another generator is ignored like a corrupted one,
+// the cache starts empty and save() overwrites the file.
+// generateId() may be called concurrently from many threads. Neither ids nor the tag
+// may contain newlines.
+class CachingIdGenerator : public IdGenerator {
+public:
+    CachingIdGenerator(IdGenerator const& idGeneratorArg, std::string const& generatorTagArg,
+        std::string const& cacheFilenameArg)
+        : idGenerator(idGeneratorArg)
+        , generatorTag(generatorTagArg)
+        , cacheFilename(cacheFilenameArg)
+        , numHits(0)
+        , numMisses(0)
+    {
+        this->load();
+    }
+
+    virtual PageId generateId(std::string const& content) const
+    {
+        ContentFingerprint fingerprint { XxHash64::hash(content.data(), content.size()), content.size() };
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex);
+            auto iter = this->cache.find(fingerprint);
+            if (iter != this->cache.end()) {
+                ++this->numHits;
+                iter->second.used = true;
+                return iter->second.id;
+            }
+        }
+
+        ++this->numMisses;
+        PageId pageId = this->idGenerator.generateId(content);
+
+        std::unique_lock<std::shared_timed_mutex> lock(this->mutex);
+        this->cache.emplace(std::piecewise_construct, std::forward_as_tuple(fingerprint),
+            std::forward_as_tuple(pageId, true));
+        return pageId;
+    }
+
+    // Writes the entries looked up since the cache was loaded (generated ones included) to a
+    // temporary file first, so a crash never leaves a truncated cache behind
+    bool save() const
+    {
+        std::string tempFilename = this->cacheFilename + ".tmp";
+        std::ofstream out(tempFilename, std::ios::trunc);
+        out << HEADER << this->generatorTag << "\n";
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(this->mutex);
+            for (auto const& entry : this->cache) {
+                if (entry.second.used) {
+                    out << entry.first.hash << " " << entry.first.length << " " << entry.second.id << "\n";
+                }
+            }
+        }
+        // The last buffered entries are only written out by close, which can fail as well (e.g. disk full)
+        out.close();
+        if (out.fail()) {
+            std::remove(tempFilename.data());
+            return false;
+        }
+        return std::rename(tempFilename.data(), this->cacheFilename.data()) == 0;
+    }
+
+    IdCacheStats getStats() const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(this->mutex);
+        return IdCacheStats { this->numHits, this->numMisses, this->cache.size() };
+    }
+
+private:
+    void load()
+    {
+        std::ifstream in(this->cacheFilename);
+        std::string line;
+        if (not std::getline(in, line)) {
+            return;
+        }
+        if (line != HEADER + this->generatorTag) {
+            std::cerr << "Ignoring id cache file of another generator or format: " << this->cacheFilename << std::endl;
+            return;
+        }
+        while (std::getline(in, line)) {
+            // Every entry ends with a newline, so reaching the end of the file within one means it was truncated
+            if (in.eof() or not this->loadEntry(line)) {
+                std::cerr << "Ignoring corrupted id cache file: " << this->cacheFilename << std::endl;
+                this->cache.clear();
+                return;
+            }
+        }
+    }
+
+    bool loadEntry(std::string const& line)
+    {
+        std::istringstream entry(line);
+        uint64_t hash, length;
+        std::string id;
+        if (not (entry >> hash >> length) or entry.get() != ' ' or not std::getline(entry, id) or id.empty()) {
+            return false;
+        }
+        this->cache.emplace(std::piecewise_construct, std::forward_as_tuple(ContentFingerprint { hash, length }),
+            std::forward_as_tuple(PageId(id), false));
+        return true;
+    }
+
+    struct Entry {
+        Entry(PageId const& idArg, bool usedArg)
+            : id(idArg)
+            , used(usedArg)
+        {
+        }
+
+        PageId id;
+        // Whether looked up since the cache was loaded, only those are saved
+        std::atomic<bool> used;
+    };
+
+    // First line of the file, followed by the generator tag
+    static constexpr char const* HEADER = "idcache 1 ";
+
+    IdGenerator const& idGenerator;
+    std::string generatorTag;
+    std::string cacheFilename;
+
+    mutable std::unordered_map<ContentFingerprint, Entry, ContentFingerprintHash> cache;
+    mutable std::shared_timed_mutex mutex;
+    mutable std::atomic<size_t> numHits;
+    mutable std::atomic<size_t> numMisses;
+};
+
+#endif /* SRC_CACHINGIDGENERATOR_HPP_ */
@@ -0,0 +1,445 @@
+#ifndef SRC_COMPILEDNETWORK_HPP_
+#define SRC_COMPILEDNETWORK_HPP_
+
+#include <limits>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "immutable/common.hpp"
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "hardwareCounters.hpp"
+
+// Links of a Network in the form expected by CompiledNetwork::compile
+class NetworkLinks {
+public:
+    NetworkLinks(Network const& networkArg)
+        : pages(networkArg.getPages())
+    {
+    }
+
+    size_t getNumLinks(size_t page) const
+    {
+        return this->pages[page].getLinks().size();
+    }
+
+    std::string_view getLink(size_t page, size_t link) const
+    {
+        return this->pages[page].getLinks()[link].getView();
+    }
+
+private:
+    std::vector<Page> const& pages;
+};
+
+// Buffers used while compiling, see CompiledNetwork::compileInto
+template <typename Index>
+struct CompileScratch {
+    std::vector<Index> pageOutDegrees;
+    std::vector<Index> linkOffsets;
+    std::vector<Index> targets;
+    std::vector<Index> positions;
+    std::vector<Index> vertexTable;
+};
+
+// Network translated from string ids to dense vertex indices, split into two parts:
+//  - sources: pages without in-links. After the first iteration every source ranks
+//    exactly the base value, so sources are not iterated over at all. They share
+//    a single rank, and what they contribute to the pages they link to is folded
+//    into sourceWeights.
+//  - the core: all other pages, vertex v of the core is the v-th of them in page
+//    order, and pageVertices maps pages to core vertices (or NO_VERTEX for sources).
+// In-edges between core vertices are kept in CSR form, the sources of the in-edges
+// of v are inSources[inOffsets[v]] .. inSources[inOffsets[v + 1] - 1] in increasing
+// order. Links to pages outside of the network are dropped, but still count to the
+// out-degree, exactly like in SingleThreadedPageRankComputer.
+//
+// Index is the type of both vertex and edge indices, so graphs with less than 4G
+// vertices and in-edges can be compiled with 32-bit indices and read half the bytes
+// per edge. A page linking the same page k times is a single in-edge of weight k,
+// networks without such duplicate links are unweighted and have no weights at all.
+template <typename Index>
+class CompiledNetwork {
+public:
+    static constexpr Index NO_VERTEX = std::numeric_limits<Index>::max();
+
+    // Whether a network with numVertices pages and numLinks links in total fits into Index
+    static bool canIndex(size_t numVertices, size_t numLinks)
+    {
+        return numVertices < NO_VERTEX and numLinks < NO_VERTEX;
+    }
+
+    // Page ids have to be generated already
+    static CompiledNetwork compile(Network const& network, uint32_t numThreads)
+    {
+        std::vector<WorkMeasurement> measurements(numThreads);
+        return compile(network, numThreads, measurements, false, false);
+    }
+
+    // Links are resolved to vertex indices by numThreads threads, which report their work in measurements
+    static CompiledNetwork compile(Network const& network, uint32_t numThreads,
+        std::vector<WorkMeasurement>& measurements, bool timed, bool counted)
+    {
+        std::vector<PageId> ids;
+        ids.reserve(network.getSize());
+        for (auto const& page : network.getPages()) {
+            ids.push_back(page.getId());
+        }
+        return compile(std::move(ids), NetworkLinks(network), numThreads, measurements, timed, counted);
+    }
+
+    // ids[v] is the id of vertex v, links provide getNumLinks(v) and getLink(v, i) convertible
+    // to std::string_view, like ArenaNetwork or NetworkLinks
+    template <typename LinkSource>
+    static CompiledNetwork compile(std::vector<PageId>&& ids, LinkSource const& links, uint32_t numThreads,
+        std::vector<WorkMeasurement>& measurements, bool timed, bool counted, bool withPageLinks = false)
+    {
+        CompiledNetwork compiled;
+        CompileScratch<Index> scratch;
+        compileInto(compiled, scratch, std::move(ids), links, numThreads, measurements, timed, counted, withPageLinks);
+        return compiled;
+    }
+
+    // Like compile, but reuses the buffers of compiled and scratch, so compiling many small
+    // networks one after another hardly allocates. A single thread resolves links inline.
+    template <typename LinkSource>
+    static void compileInto(CompiledNetwork& compiled, CompileScratch<Index>& scratch, std::vector<PageId>&& ids,
+        LinkSource const& links, uint32_t numThreads, std::vector<WorkMeasurement>& measurements, bool timed,
+        bool counted, bool withPageLinks = false)
+    {
+        compiled.clear();
+        compiled.ids = std::move(ids);
+        Index numPages = static_cast<Index>(compiled.ids.size());
+
+        // Links of page p become targets[linkOffsets[p]] .. targets[linkOffsets[p + 1] - 1]
+        std::vector<Index>& outDegrees = scratch.pageOutDegrees;
+        std::vector<Index>& linkOffsets = scratch.linkOffsets;
+        outDegrees.resize(numPages);
+        linkOffsets.assign(numPages + 1, 0);
+        for (Index p = 0; p < numPages; ++p) {
+            size_t numLinks = links.getNumLinks(p);
+            ASSERT(canIndex(numPages, linkOffsets[p] + numLinks), "Network too big for the index type");
+            outDegrees[p] = static_cast<Index>(numLinks);
+            linkOffsets[p + 1] = linkOffsets[p] + outDegrees[p];
+        }
+        compiled.fillVertexTable(scratch.vertexTable);
+
+        // Hash lookups dominate the compilation, every thread resolves links of its own range of pages
+        std::vector<Index>& targets = scratch.targets;
+        targets.resize(linkOffsets[numPages]);
+        auto resolveLinks = [&](uint32_t t) {
+            WorkProbe probe(timed, counted);
+            Index begin = static_cast<Index>(static_cast<uint64_t>(numPages) * t / numThreads);
+            Index end = static_cast<Index>(static_cast<uint64_t>(numPages) * (t + 1) / numThreads);
+            for (Index p = begin; p < end; ++p) {
+                for (Index link = 0; link < outDegrees[p]; ++link) {
+                    targets[linkOffsets[p] + link] = compiled.findVertex(scratch.vertexTable, links.getLink(p, link));
+                }
+            }
+            probe.finish(measurements[t]);
+        };
+        if (numThreads == 1) {
+            resolveLinks(0);
+        } else {
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < numThreads; ++t) {
+                threads.push_back(std::thread { resolveLinks, t });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        // Pages linked from anywhere form the core, linked pages are never sources
+        compiled.pageVertices.assign(numPages, NO_VERTEX);
+        for (Index target : targets) {
+            if (target != NO_VERTEX) {
+                compiled.pageVertices[target] = 0;
+            }
+        }
+        Index numCoreVertices = 0;
+        for (Index p = 0; p < numPages; ++p) {
+            if (compiled.pageVertices[p] != NO_VERTEX) {
+                compiled.pageVertices[p] = numCoreVertices++;
+                compiled.outDegrees.push_back(outDegrees[p]);
+                if (outDegrees[p] == 0) {
+                    compiled.danglingVertices.push_back(compiled.pageVertices[p]);
+                }
+            } else {
+                ++compiled.numSources;
+                compiled.numDanglingSources += outDegrees[p] == 0;
+            }
+        }
+
+        compiled.inOffsets.assign(numCoreVertices + 1, 0);
+        for (Index p = 0; p < numPages; ++p) {
+            if (compiled.pageVertices[p] != NO_VERTEX) {
+                for (Index link = linkOffsets[p]; link < linkOffsets[p + 1]; ++link) {
+                    if (targets[link] != NO_VERTEX) {
+                        ++compiled.inOffsets[compiled.pageVertices[targets[link]] + 1];
+                    }
+                }
+            }
+        }
+        for (Index v = 0; v < numCoreVertices; ++v) {
+            compiled.inOffsets[v + 1] += compiled.inOffsets[v];
+        }
+
+        // Pages are visited in increasing order, so every in-edge list ends up sorted
+        std::vector<Index>& positions = scratch.positions;
+        positions.assign(compiled.inOffsets.begin(), compiled.inOffsets.end() - 1);
+        compiled.inSources.resize(compiled.inOffsets[numCoreVertices]);
+        bool hasDuplicates = false;
+        for (Index p = 0; p < numPages; ++p) {
+            Index source = compiled.pageVertices[p];
+            for (Index link = linkOffsets[p]; link < linkOffsets[p + 1]; ++link) {
+                if (targets[link] == NO_VERTEX) {
+                    continue;
+                }
+                Index target = compiled.pageVertices[targets[link]];
+                if (source == NO_VERTEX) {
+                    if (compiled.sourceWeights.empty()) {
+                        compiled.sourceWeights.assign(numCoreVertices, 0);
+                    }
+                    compiled.sourceWeights[target] += 1.0 / outDegrees[p];
+                } else {
+                    Index position = positions[target]++;
+                    hasDuplicates |= position > compiled.inOffsets[target] and compiled.inSources[position - 1] == source;
+                    compiled.inSources[position] = source;
+                }
+            }
+        }
+
+        if (hasDuplicates) {
+            compiled.mergeDuplicateEdges();
+        }
+        if (withPageLinks) {
+            compiled.pageLinkOffsets.assign(linkOffsets.begin(), linkOffsets.end());
+            compiled.pageLinkTargets.assign(targets.begin(), targets.end());
+        }
+    }
+
+    // Number of all pages, sources included
+    Index getNumVertices() const
+    {
+        return static_cast<Index>(this->ids.size());
+    }
+
+    Index getNumCoreVertices() const
+    {
+        return static_cast<Index>(this->outDegrees.size());
+    }
+
+    // Number of in-edges between core vertices
+    Index getNumEdges() const
+    {
+        return static_cast<Index>(this->inSources.size());
+    }
+
+    // Ids of all pages, in page order
+    std::vector<PageId> const& getIds() const
+    {
+        return this->ids;
+    }
+
+    // Core vertex of every page, NO_VERTEX for sources
+    std::vector<Index> const& getPageVertices() const
+    {
+        return this->pageVertices;
+    }
+
+    // Pairs every page, in page order, with the rank of its core vertex, or with sourceRank
+    template <typename Rank>
+    std::vector<PageIdAndRank> collectRanks(std::vector<Rank> const& ranks, Rank sourceRank) const
+    {
+        std::vector<PageIdAndRank> result;
+        result.reserve(this->getNumVertices());
+        for (Index p = 0; p < this->getNumVertices(); ++p) {
+            Index v = this->pageVertices[p];
+            result.push_back(PageIdAndRank(this->ids[p], v == NO_VERTEX ? sourceRank : ranks[v]));
+        }
+        return result;
+    }
+
+    std::vector<Index> const& getInOffsets() const
+    {
+        return this->inOffsets;
+    }
+
+    std::vector<Index> const& getInSources() const
+    {
+        return this->inSources;
+    }
+
+    // Multiplicity of every in-edge, empty for unweighted networks
+    std::vector<Index> const& getInWeights() const
+    {
+        return this->inWeights;
+    }
+
+    std::vector<Index> const& getOutDegrees() const
+    {
+        return this->outDegrees;
+    }
+
+    // All links of page p, sources included, are pageLinkTargets[pageLinkOffsets[p]] ..
+    // pageLinkTargets[pageLinkOffsets[p + 1] - 1]: pages in link order, NO_VERTEX for links
+    // outside of the network. Both are empty unless compiled withPageLinks.
+    std::vector<Index> const& getPageLinkOffsets() const
+    {
+        return this->pageLinkOffsets;
+    }
+
+    std::vector<Index> const& getPageLinkTargets() const
+    {
+        return this->pageLinkTargets;
+    }
+
+    // Core vertices without out-links
+    std::vector<Index> const& getDanglingVertices() const
+    {
+        return this->danglingVertices;
+    }
+
+    // For every core vertex, sum of 1 / outDegree over its in-links from sources, so that
+    // sources give it sourceRank * alpha * sourceWeight. Empty when no source has links.
+    std::vector<double> const& getSourceWeights() const
+    {
+        return this->sourceWeights;
+    }
+
+    Index getNumSources() const
+    {
+        return this->numSources;
+    }
+
+    // Isolated pages: sources without out-links, their rank goes to the dangling sum
+    Index getNumDanglingSources() const
+    {
+        return this->numDanglingSources;
+    }
+
+    bool hasDanglingVertices() const
+    {
+        return not this->danglingVertices.empty() or this->numDanglingSources > 0;
+    }
+
+    bool isWeighted() const
+    {
+        return not this->inWeights.empty();
+    }
+
+    // Splits core vertices into numParts contiguous ranges with about the same number of
+    // vertices plus in-edges each; part p is [boundaries[p], boundaries[p + 1])
+    std::vector<Index> partition(uint32_t numParts) const
+    {
+        Index numVertices = this->getNumCoreVertices();
+        uint64_t totalWork = static_cast<uint64_t>(numVertices) + this->getNumEdges();
+
+        std::vector<Index> boundaries(numParts + 1, numVertices);
+        boundaries[0] = 0;
+        Index v = 0;
+        for (uint32_t p = 1; p < numParts; ++p) {
+            uint64_t work = totalWork * p / numParts;
+            while (v < numVertices and static_cast<uint64_t>(v) + this->inOffsets[v] < work) {
+                ++v;
+            }
+            boundaries[p] = v;
+        }
+        return boundaries;
+    }
+
+    // Empty network, to be filled by compileInto
+    CompiledNetwork()
+        : numSources(0)
+        , numDanglingSources(0)
+    {
+    }
+
+private:
+    // Keeps the capacity of all buffers
+    void clear()
+    {
+        this->pageVertices.clear();
+        this->inOffsets.clear();
+        this->inSources.clear();
+        this->inWeights.clear();
+        this->outDegrees.clear();
+        this->pageLinkOffsets.clear();
+        this->pageLinkTargets.clear();
+        this->danglingVertices.clear();
+        this->sourceWeights.clear();
+        this->numSources = 0;
+        this->numDanglingSources = 0;
+    }
+
+    // Open addressing with linear probing, slots hold vertices or NO_VERTEX. The first
+    // of pages with equal ids wins.
+    void fillVertexTable(std::vector<Index>& table) const
+    {
+        size_t size = 16;
+        while (size < 2 * this->ids.size()) {
+            size *= 2;
+        }
+        table.assign(size, NO_VERTEX);
+        for (Index p = 0; p < this->getNumVertices(); ++p) {
+            Index& slot = table[this->findSlot(table, this->ids[p].getView())];
+            if (slot == NO_VERTEX) {
+                slot = p;
+            }
+        }
+    }
+
+    Index findVertex(std::vector<Index> const& table, std::string_view id) const
+    {
+        return table[this->findSlot(table, id)];
+    }
+
+    // Slot holding the vertex with id, or the empty slot where it belongs
+    size_t findSlot(std::vector<Index> const& table, std::string_view id) const
+    {
+        size_t mask = table.size() - 1;
+        size_t slot = std::hash<std::string_view> {}(id) & mask;
+        while (table[slot] != NO_VERTEX and this->ids[table[slot]].getView() != id) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    // Replaces runs of equal sources (always adjacent, as the lists are sorted) with a single weighted edge
+    void mergeDuplicateEdges()
+    {
+        Index numVertices = this->getNumCoreVertices();
+        std::vector<Index> mergedOffsets(numVertices + 1, 0);
+        std::vector<Index> mergedSources;
+        for (Index v = 0; v < numVertices; ++v) {
+            for (Index edge = this->inOffsets[v]; edge < this->inOffsets[v + 1]; ++edge) {
+                if (edge > this->inOffsets[v] and this->inSources[edge] == mergedSources.back()) {
+                    ++this->inWeights.back();
+                } else {
+                    mergedSources.push_back(this->inSources[edge]);
+                    this->inWeights.push_back(1);
+                }
+            }
+            mergedOffsets[v + 1] = static_cast<Index>(mergedSources.size());
+        }
+        this->inOffsets.swap(mergedOffsets);
+        this->inSources.swap(mergedSources);
+    }
+
+    std::vector<PageId> ids;
+    std::vector<Index> pageVertices;
+    std::vector<Index> inOffsets;
+    std::vector<Index> inSources;
+    std::vector<Index> inWeights;
+    std::vector<Index> outDegrees;
+    std::vector<Index> pageLinkOffsets;
+    std::vector<Index> pageLinkTargets;
+    std::vector<Index> danglingVertices;
+    std::vector<double> sourceWeights;
+    Index numSources;
+    Index numDanglingSources;
+};
+
+#endif /* SRC_COMPILEDNETWORK_HPP_ */
@@ -0,0 +1,170 @@
+#ifndef SRC_HARDWARECOUNTERS_HPP_
+#define SRC_HARDWARECOUNTERS_HPP_
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "pageRankObserver.hpp"
+#include "stopwatch.hpp"
+
+// Hardware performance counters of the calling thread, read with perf_event_open(2).
+// They are opened and started on construction and count until destruction, so a thread
+// doing many pieces of work (see WorkerPool) opens them once and reads what every piece
+// took. Every counter is opened separately, so e.g. a virtual machine without LLC events
+// still gets cycles and instructions. When perf_event_open is not available at all
+// (other OS, seccomp, perf_event_paranoid, no PMU) all counters are reported as
+// unavailable and the computation goes on unaffected.
+class HardwareCounters {
+public:
+    HardwareCounters(bool enabledArg)
+        : enabled(enabledArg)
+        , lastReadings {}
+    {
+        for (uint32_t counter = 0; counter < HardwareCounterValues::NUM_COUNTERS; ++counter) {
+            this->fds[counter] = this->enabled ? openCounter(static_cast<HardwareCounterValues::Counter>(counter)) : -1;
+        }
+#ifdef __linux__
+        for (int fd : this->fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    HardwareCounters(HardwareCounters const&) = delete;
+    HardwareCounters& operator=(HardwareCounters const&) = delete;
+
+    ~HardwareCounters()
+    {
+#ifdef __linux__
+        for (int fd : this->fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    // Counts since the previous read, or since construction; no samples when not enabled
+    HardwareCounterValues read()
+    {
+        HardwareCounterValues values;
+        if (not this->enabled) {
+            return values;
+        }
+
+        values.numSamples = 1;
+#ifdef __linux__
+        for (uint32_t counter = 0; counter < HardwareCounterValues::NUM_COUNTERS; ++counter) {
+            int fd = this->fds[counter];
+            if (fd < 0) {
+                continue;
+            }
+
+            // value, time enabled, time running; the value is scaled up when the kernel multiplexed counters
+            uint64_t data[3];
+            if (::read(fd, data, sizeof(data)) != sizeof(data)) {
+                continue;
+            }
+            uint64_t* last = this->lastReadings[counter];
+            uint64_t running = data[2] - last[2];
+            if (running > 0) {
+                values.values[counter] = static_cast<uint64_t>(static_cast<double>(data[0] - last[0]) * (data[1] - last[1]) / running);
+                values.available[counter] = true;
+            }
+            std::memcpy(last, data, sizeof(data));
+        }
+#endif
+        return values;
+    }
+
+private:
+    static int openCounter(HardwareCounterValues::Counter counter)
+    {
+#ifdef __linux__
+        static uint64_t const configs[HardwareCounterValues::NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES,
+        };
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[counter];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // pid = 0, cpu = -1: the calling thread on whichever cpu it runs
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)counter;
+        return -1;
+#endif
+    }
+
+    bool enabled;
+    int fds[HardwareCounterValues::NUM_COUNTERS];
+    // Value, time enabled and time running of every counter at the previous read
+    uint64_t lastReadings[HardwareCounterValues::NUM_COUNTERS][3];
+};
+
+// Busy time and hardware counters of all the work a single thread did in one phase
+struct WorkMeasurement {
+    WorkMeasurement()
+        : busySeconds(0)
+    {
+    }
+
+    double busySeconds;
+    HardwareCounterValues counters;
+};
+
+// Measures a piece of work done by the calling thread, from construction until finish().
+// Costs nothing when the computation is not observed.
+class WorkProbe {
+public:
+    // For a thread doing this piece of work only, which opens counters of its own when counted
+    WorkProbe(bool timed, bool counted)
+        : stopwatch(timed)
+        , ownCounters(counted)
+        , counters(ownCounters)
+    {
+    }
+
+    // For a thread doing many pieces of work, with the counters it keeps open for all of them
+    WorkProbe(bool timed, HardwareCounters& threadCounters)
+        : stopwatch(timed)
+        , ownCounters(false)
+        , counters(threadCounters)
+    {
+        this->counters.read();
+    }
+
+    WorkProbe(WorkProbe const&) = delete;
+    WorkProbe& operator=(WorkProbe const&) = delete;
+
+    void finish(WorkMeasurement& measurement)
+    {
+        measurement.counters += this->counters.read();
+        measurement.busySeconds += this->stopwatch.getSeconds();
+    }
+
+private:
+    Stopwatch stopwatch;
+    HardwareCounters ownCounters;
+    HardwareCounters& counters;
+};
+
+#endif /* SRC_HARDWARECOUNTERS_HPP_ */
@@ -19,6 +19,16 @@ public:
         this->pages.push_back(page);
     }
 
+    void addPage(Page&& page)
+    {
+        this->pages.push_back(std::move(page));
+    }
+
+    void reserve(size_t numPages)
+    {
+        this->pages.reserve(numPages);
+    }
+
     size_t getSize() const
     {
         return this->pages.size();
@@ -20,6 +20,14 @@ public:
     {
     }
 
+    Page(std::string&& contentArg)
+        : id("")
+        , isIdComputed(false)
+        , content(std::move(contentArg))
+        , links()
+    {
+    }
+
     void generateId(IdGenerator const& idGenerator) const
     {
         ASSERT(not this->isIdComputed, "Generating id twice");
@@ -27,6 +35,11 @@ public:
         this->isIdComputed = true;
     }
 
+    bool isIdGenerated() const
+    {
+        return this->isIdComputed;
+    }
+
     PageId getId() const
     {
         ASSERT(this->isIdComputed, "Getting id while empty");
@@ -38,6 +51,16 @@ public:
         this->links.push_back(link);
     }
 
+    void addLink(PageId&& link)
+    {
+        this->links.push_back(std::move(link));
+    }
+
+    std::string const& getContent() const
+    {
+        return this->content;
+    }
+
     std::vector<PageId> const& getLinks() const
     {
         return this->links;
@@ -2,6 +2,7 @@
 #define PAGE_ID_HPP_
 
 #include <string>
+#include <string_view>
 
 class PageId {
 public:
@@ -10,11 +11,22 @@ public:
     {
     }
 
+    PageId(std::string&& idArg)
+        : id(std::move(idArg))
+    {
+    }
+
     bool operator==(PageId const& other) const
     {
         return this->id == other.id;
     }
 
+    // Valid as long as this PageId is alive and unchanged
+    std::string_view getView() const
+    {
+        return this->id;
+    }
+
 private:
     std::string id;
 
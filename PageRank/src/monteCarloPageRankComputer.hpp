@@ -0,0 +1,234 @@
+#ifndef SRC_MONTECARLOPAGERANKCOMPUTER_HPP_
+#define SRC_MONTECARLOPAGERANKCOMPUTER_HPP_
+
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+#include "immutable/pageRankComputer.hpp"
+#include "compiledNetwork.hpp"
+#include "hardwareCounters.hpp"
+#include "pageRankControl.hpp"
+#include "pageRankObservable.hpp"
+#include "stopwatch.hpp"
+
+// Approximates PageRank with random walks instead of solving it: walksPerPage walks
+// start at every page, and each of them, at every step, ends with probability
+// 1 - alpha, and otherwise follows a random link of its page (jumps to a random page
+// from pages without links, and ends on links outside of the network, which lose
+// their rank in the power iteration as well). The rank of a page is estimated as
+// (1 - alpha) * visits / (numPages * walksPerPage), which is exactly PageRank in
+// expectation.
+//
+// A walk visits a page ranking r about r / (1 - alpha) times on average and at most
+// 1 / (1 - alpha) more times once there, so the standard deviation of the estimate is
+// at most sqrt(r * (1 + alpha) / (numPages * walksPerPage)), and the expected sum of
+// absolute errors over all pages at most sqrt((1 + alpha) / walksPerPage). For a page
+// ranking the average 1 / numPages, the relative error is about sqrt((1 + alpha) / walksPerPage),
+// while the top pages are estimated much more precisely, so a few walks per page are
+// enough to find them.
+//
+// Every thread walks from its own range of pages with its own random generator and
+// counts visits on its own; the counts are merged at the end. Results are the same
+// for the same seed and number of threads.
+class MonteCarloPageRankComputer : public PageRankComputer, public PageRankControllable, public PageRankObservable {
+public:
+    MonteCarloPageRankComputer(uint32_t numThreadsArg, uint32_t walksPerPageArg, uint64_t seedArg = 0)
+        : numThreads(numThreadsArg)
+        , walksPerPage(walksPerPageArg)
+        , seed(seedArg)
+    {
+    }
+
+    // Ranks are estimates, iterations and tolerance are not used
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha, uint32_t iterations,
+        double tolerance) const
+    {
+        return std::move(this->computeWithControl(network, alpha, iterations, tolerance, nullptr).ranks);
+    }
+
+    // Residual of the result is getExpectedError, and it converged if that is below tolerance.
+    // Walks take no iterations, so they cannot be cancelled or snapshotted.
+    PageRankResult computeWithControl(Network const& network, double alpha, uint32_t /* iterations */,
+        double tolerance, PageRankControl* control) const
+    {
+        bool instrumented = this->observer != nullptr;
+        if (instrumented) {
+            this->observer->onComputationStarted(this->getName(), network.getSize());
+        }
+        bool counted = instrumented and this->observer->wantsHardwareCounters();
+        Stopwatch phaseStopwatch(instrumented);
+        std::vector<WorkMeasurement> measurements(this->numThreads);
+
+        auto const& pages = network.getPages();
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < this->numThreads; ++t) {
+            threads.push_back(std::thread { [&, t] {
+                WorkProbe probe(instrumented, counted);
+                for (size_t i = pages.size() * t / this->numThreads; i < pages.size() * (t + 1) / this->numThreads; ++i) {
+                    if (not pages[i].isIdGenerated()) {
+                        pages[i].generateId(network.getGenerator());
+                    }
+                }
+                probe.finish(measurements[t]);
+            } });
+        }
+        joinThreads(threads);
+
+        std::vector<PageId> ids;
+        ids.reserve(pages.size());
+        size_t numLinks = 0;
+        for (auto const& page : pages) {
+            ids.push_back(page.getId());
+            numLinks += page.getLinks().size();
+        }
+        this->finishPhase("generateIds", phaseStopwatch, measurements);
+
+        std::vector<PageIdAndRank> ranks = CompiledNetwork<uint32_t>::canIndex(ids.size(), numLinks)
+            ? this->walkNetwork<uint32_t>(std::move(ids), network, alpha, phaseStopwatch, measurements)
+            : this->walkNetwork<uint64_t>(std::move(ids), network, alpha, phaseStopwatch, measurements);
+
+        if (control != nullptr) {
+            control->onFinished();
+        }
+        double expectedError = getExpectedError(alpha, this->walksPerPage);
+        return PageRankResult { std::move(ranks), 0, expectedError, expectedError < tolerance, false };
+    }
+
+    // Bound on the expected sum of absolute errors of the estimates of all pages
+    static double getExpectedError(double alpha, uint32_t walksPerPage)
+    {
+        return std::sqrt((1 + alpha) / walksPerPage);
+    }
+
+    // Bound on the standard deviation of the estimate of a page ranking rank in a network of numPages pages
+    static double getStandardErrorBound(double alpha, size_t numPages, uint32_t walksPerPage, PageRank rank)
+    {
+        return std::sqrt(rank * (1 + alpha) / (static_cast<double>(numPages) * walksPerPage));
+    }
+
+    std::string getName() const
+    {
+        return "MonteCarloPageRankComputer[" + std::to_string(this->numThreads) + ", "
+            + std::to_string(this->walksPerPage) + " walks]";
+    }
+
+private:
+    template <typename Index>
+    std::vector<PageIdAndRank> walkNetwork(std::vector<PageId>&& ids, Network const& network, double alpha,
+        Stopwatch& phaseStopwatch, std::vector<WorkMeasurement>& measurements) const
+    {
+        bool instrumented = this->observer != nullptr;
+        bool counted = instrumented and this->observer->wantsHardwareCounters();
+        CompiledNetwork<Index> compiled = CompiledNetwork<Index>::compile(std::move(ids), NetworkLinks(network),
+            this->numThreads, measurements, instrumented, counted, true);
+        this->finishPhase("buildGraph", phaseStopwatch, measurements);
+
+        Index numPages = compiled.getNumVertices();
+        Index const* linkOffsets = compiled.getPageLinkOffsets().data();
+        Index const* linkTargets = compiled.getPageLinkTargets().data();
+        std::vector<std::vector<uint64_t>> visits(this->numThreads);
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < this->numThreads; ++t) {
+            threads.push_back(std::thread { [&, t] {
+                WorkProbe probe(instrumented, counted);
+                std::vector<uint64_t>& threadVisits = visits[t];
+                threadVisits.assign(numPages, 0);
+                std::seed_seq seedSequence { static_cast<uint32_t>(this->seed), static_cast<uint32_t>(this->seed >> 32), t };
+                std::mt19937_64 random(seedSequence);
+                std::bernoulli_distribution continues(alpha);
+
+                Index begin = static_cast<Index>(static_cast<uint64_t>(numPages) * t / this->numThreads);
+                Index end = static_cast<Index>(static_cast<uint64_t>(numPages) * (t + 1) / this->numThreads);
+                for (Index start = begin; start < end; ++start) {
+                    for (uint32_t walk = 0; walk < this->walksPerPage; ++walk) {
+                        Index page = start;
+                        while (true) {
+                            ++threadVisits[page];
+                            if (not continues(random)) {
+                                break;
+                            }
+                            Index numLinks = linkOffsets[page + 1] - linkOffsets[page];
+                            if (numLinks == 0) {
+                                page = std::uniform_int_distribution<Index>(0, numPages - 1)(random);
+                                continue;
+                            }
+                            page = linkTargets[linkOffsets[page] + std::uniform_int_distribution<Index>(0, numLinks - 1)(random)];
+                            if (page == CompiledNetwork<Index>::NO_VERTEX) {
+                                break;
+                            }
+                        }
+                    }
+                }
+                probe.finish(measurements[t]);
+            } });
+        }
+        joinThreads(threads);
+        this->finishPhase("walks", phaseStopwatch, measurements);
+
+        // Every thread sums up the visits of its own range of pages
+        double scale = (1 - alpha) / (static_cast<double>(numPages) * this->walksPerPage);
+        std::vector<PageRank> ranks(numPages);
+        for (uint32_t t = 0; t < this->numThreads; ++t) {
+            threads.push_back(std::thread { [&, t] {
+                WorkProbe probe(instrumented, counted);
+                Index begin = static_cast<Index>(static_cast<uint64_t>(numPages) * t / this->numThreads);
+                Index end = static_cast<Index>(static_cast<uint64_t>(numPages) * (t + 1) / this->numThreads);
+                for (Index page = begin; page < end; ++page) {
+                    uint64_t pageVisits = 0;
+                    for (auto const& threadVisits : visits) {
+                        pageVisits += threadVisits[page];
+                    }
+                    ranks[page] = scale * pageVisits;
+                }
+                probe.finish(measurements[t]);
+            } });
+        }
+        joinThreads(threads);
+        this->finishPhase("mergeVisits", phaseStopwatch, measurements);
+
+        std::vector<PageIdAndRank> result;
+        result.reserve(numPages);
+        for (Index page = 0; page < numPages; ++page) {
+            result.push_back(PageIdAndRank(compiled.getIds()[page], ranks[page]));
+        }
+        if (instrumented) {
+            this->observer->onPhaseFinished("collectResult", phaseStopwatch.getSeconds());
+        }
+        return result;
+    }
+
+    static void joinThreads(std::vector<std::thread>& threads)
+    {
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+    void finishPhase(std::string const& phase, Stopwatch& stopwatch, std::vector<WorkMeasurement>& measurements) const
+    {
+        if (this->observer != nullptr) {
+            double seconds = stopwatch.getSeconds();
+            this->observer->onPhaseFinished(phase, seconds);
+            for (uint32_t t = 0; t < this->numThreads; t++) {
+                double busySeconds = measurements[t].busySeconds;
+                this->observer->onThreadFinished(phase, t, busySeconds, seconds - busySeconds);
+                if (measurements[t].counters.numSamples > 0) {
+                    this->observer->onThreadCounters(phase, t, measurements[t].counters);
+                }
+            }
+        }
+        std::fill(measurements.begin(), measurements.end(), WorkMeasurement());
+        stopwatch.restart();
+    }
+
+    uint32_t numThreads;
+    uint32_t walksPerPage;
+    uint64_t seed;
+};
+
+#endif /* SRC_MONTECARLOPAGERANKCOMPUTER_HPP_ */
@@ -1,17 +1,23 @@
 #ifndef SRC_MULTITHREADEDPAGERANKCOMPUTER_HPP_
 #define SRC_MULTITHREADEDPAGERANKCOMPUTER_HPP_
 
-#include <atomic>
-#include <mutex>
+#include <memory>
 #include <thread>
-
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "immutable/network.hpp"
 #include "immutable/pageIdAndRank.hpp"
 #include "immutable/pageRankComputer.hpp"
+#include "arenaNetwork.hpp"
+#include "compiledNetwork.hpp"
+#include "hardwareCounters.hpp"
+#include "pageRankControl.hpp"
+#include "pageRankObservable.hpp"
+#include "pageRankIteration.hpp"
+#include "pageRankKernel.hpp"
+#include "preparedNetwork.hpp"
+#include "stopwatch.hpp"
+#include "workerPool.hpp"
 
 static void joinAndClearThreads (std::vector<std::thread> &threads) {
     for (std::thread &thread : threads) {
@@ -21,185 +27,313 @@ static void joinAndClearThreads (std::vector<std::thread> &threads) {
     threads.clear();
 }
 
-struct PageRankComputerState {
-    PageRankComputerState(std::unordered_map<PageId, PageRank, PageIdHash> &pageHashMap,
-                          std::unordered_map<PageId, std::vector<PageId>, PageIdHash> &edges,
-                          std::unordered_map<PageId, uint32_t, PageIdHash> &numLinks,
-                          double alpha):
-            pageHashMap(pageHashMap), edges(edges), numLinks(numLinks),
-            alpha(alpha), baseValue(0)
-    {}
-
-    std::unordered_map<PageId, PageRank, PageIdHash> &pageHashMap;
-    std::unordered_map<PageId, std::vector<PageId>, PageIdHash> &edges;
-    std::unordered_map<PageId, uint32_t, PageIdHash> &numLinks;
-    double alpha;
-    double baseValue;
-};
-
-static void preparePages(const PageRankComputerState &state,
-                         const std::vector<const Page*> &pagesToId, const IdGenerator &generator,
-                         std::vector<PageId> &myManagedPages, std::vector<PageId> &myDanglingNodes,
-                         std::mutex &mutex, const double startValue) {
-
-    for (auto const &page : pagesToId) {
-        page->generateId(generator);
-
-        myManagedPages.push_back(page->getId());
-        if (page->getLinks().size() == 0) {
-            myDanglingNodes.push_back(page->getId());
+static void generatePageIds(std::vector<Page> const &pages, size_t begin, size_t end, const IdGenerator &generator) {
+    for (size_t i = begin; i < end; ++i) {
+        if (not pages[i].isIdGenerated()) {
+            pages[i].generateId(generator);
         }
-
     }
+}
 
-    std::lock_guard<std::mutex> lock(mutex);
-    for (auto const &page : pagesToId) {
-        PageId pageId = page->getId();
+class MultiThreadedPageRankComputer : public PageRankComputer, public PageRankControllable, public PageRankObservable {
+public:
+    MultiThreadedPageRankComputer(uint32_t numThreadsArg, bool fusedIterationArg = true, bool singlePrecisionArg = false)
+        : numThreads(numThreadsArg), fusedIteration(fusedIterationArg), singlePrecision(singlePrecisionArg) {};
 
-        state.numLinks[pageId] = page->getLinks().size();
+    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha,
+                                                 uint32_t iterations, double tolerance) const
+    {
+        PageRankResult result = this->computeWithControl(network, alpha, iterations, tolerance, nullptr);
+        ASSERT(result.converged, "Not able to find result in iterations=" << iterations);
+        return std::move(result.ranks);
+    }
 
-        for (auto link : page->getLinks()) {
-            state.edges[link].push_back(pageId);
-        }
+    // Same computation for a network loaded into an arena, results are in the order of its pages
+    std::vector<PageIdAndRank> computeForNetwork(ArenaNetwork const& network, double alpha,
+                                                 uint32_t iterations, double tolerance) const
+    {
+        PageRankResult result = this->computeWithControl(network, alpha, iterations, tolerance, nullptr);
+        ASSERT(result.converged, "Not able to find result in iterations=" << iterations);
+        return std::move(result.ranks);
+    }
 
-        state.pageHashMap[pageId] = startValue;
+    PageRankResult computeWithControl(Network const& network, double alpha, uint32_t iterations,
+                                      double tolerance, PageRankControl* control) const
+    {
+        this->notifyStarted(network.getSize());
+        Stopwatch phaseStopwatch(this->observer != nullptr);
+        PreparedNetwork prepared = this->prepareNetwork(network, phaseStopwatch);
+        return this->computePrepared(prepared, alpha, iterations, tolerance, control, phaseStopwatch);
     }
-}
 
-static void calculateDangleSum(std::unordered_map<PageId, PageRank, PageIdHash> &previousPageHashMap,
-                               const std::vector<PageId> &danglingNodes, double &dangleSum, std::mutex &mutex) {
-    double myDangleSum = 0;
-    for (PageId const &danglingNode : danglingNodes) {
-        myDangleSum += previousPageHashMap[danglingNode];
+    PageRankResult computeWithControl(ArenaNetwork const& network, double alpha, uint32_t iterations,
+                                      double tolerance, PageRankControl* control) const
+    {
+        this->notifyStarted(network.getSize());
+        Stopwatch phaseStopwatch(this->observer != nullptr);
+        PreparedNetwork prepared = this->prepareNetwork(network, phaseStopwatch);
+        return this->computePrepared(prepared, alpha, iterations, tolerance, control, phaseStopwatch);
     }
 
-    std::lock_guard<std::mutex> lock(mutex);
-    dangleSum += myDangleSum;
-}
+    // Generates ids and builds the graph once, for computations that differ only in their parameters.
+    // The observer sees the generateIds and buildGraph phases here, and only the iterations later.
+    PreparedNetwork prepare(Network const& network) const
+    {
+        this->notifyStarted(network.getSize());
+        Stopwatch phaseStopwatch(this->observer != nullptr);
+        return this->prepareNetwork(network, phaseStopwatch);
+    }
 
-static void calculatePageRank(const PageRankComputerState &state,
-                              std::unordered_map<PageId, PageRank, PageIdHash> &previousPageHashMap,
-                              const std::vector<PageId> &pages, std::mutex &mutex, double &difference) {
-    double myDifference = 0;
-    for (PageId const &pageId : pages) {
-        auto pageMapElem = state.pageHashMap.find(pageId);
-        pageMapElem->second = state.baseValue;
-
-        if (state.edges.count(pageId) > 0) {
-            for (auto link : state.edges[pageId]) {
-                pageMapElem->second += state.alpha * previousPageHashMap[link] / state.numLinks[link];
-            }
-        }
+    PreparedNetwork prepare(ArenaNetwork const& network) const
+    {
+        this->notifyStarted(network.getSize());
+        Stopwatch phaseStopwatch(this->observer != nullptr);
+        return this->prepareNetwork(network, phaseStopwatch);
+    }
 
-        myDifference += std::abs(previousPageHashMap[pageId] - pageMapElem->second);
+    // Results are in the order of the pages of the prepared network
+    std::vector<PageIdAndRank> computeForNetwork(PreparedNetwork const& prepared, double alpha,
+                                                 uint32_t iterations, double tolerance) const
+    {
+        PageRankResult result = this->computeWithControl(prepared, alpha, iterations, tolerance, nullptr);
+        ASSERT(result.converged, "Not able to find result in iterations=" << iterations);
+        return std::move(result.ranks);
     }
 
-    std::lock_guard<std::mutex> lock(mutex);
-    difference += myDifference;
-}
+    PageRankResult computeWithControl(PreparedNetwork const& prepared, double alpha, uint32_t iterations,
+                                      double tolerance, PageRankControl* control) const
+    {
+        this->notifyStarted(prepared.getSize());
+        Stopwatch phaseStopwatch(this->observer != nullptr);
+        return this->computePrepared(prepared, alpha, iterations, tolerance, control, phaseStopwatch);
+    }
 
-class MultiThreadedPageRankComputer : public PageRankComputer {
-public:
-    MultiThreadedPageRankComputer(uint32_t numThreadsArg)
-        : numThreads(numThreadsArg) {};
+    std::string getName() const
+    {
+        return "MultiThreadedPageRankComputer[" + std::to_string(this->numThreads)
+               + (this->fusedIteration ? "" : ", two-pass") + (this->singlePrecision ? ", float" : "")
+               + "]";
+    }
 
-    std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha,
-                                                 uint32_t iterations, double tolerance) const
+    //todo destruktor moze
+
+private:
+    void notifyStarted(size_t numPages) const
     {
-        size_t networkSize = network.getSize();
-        std::vector<std::thread> threads;
-        std::vector<std::vector<PageId>> managedPages; // each helper thread will have a vector of Pages that it manages
-        std::vector<std::vector<PageId>> managedDanglingNodes; // same for dangling nodes
-        std::vector<std::vector<const Page*>> managedPagesGenerateId; // also for generating ids for Pages
-
-        managedPages.resize(numThreads);
-        managedDanglingNodes.resize(numThreads);
-        managedPagesGenerateId.resize(numThreads);
-
-        std::unordered_map<PageId, PageRank, PageIdHash> pageHashMap;
-        uint32_t manager = 0;
-        auto &generator = network.getGenerator();
-        for (auto &page : network.getPages()) {
-            managedPagesGenerateId[manager].push_back(&page);
-            manager = (manager + 1) % numThreads;
+        if (this->observer != nullptr) {
+            this->observer->onComputationStarted(this->getName(), numPages);
         }
+    }
 
-        std::unordered_map<PageId, uint32_t, PageIdHash> numLinks;
-        std::unordered_map<PageId, std::vector<PageId>, PageIdHash> edges;
-        PageRankComputerState state = PageRankComputerState(pageHashMap, edges, numLinks, alpha);
+    PreparedNetwork prepareNetwork(Network const& network, Stopwatch &phaseStopwatch) const
+    {
+        bool instrumented = this->observer != nullptr;
+        bool counted = instrumented and this->observer->wantsHardwareCounters();
+        std::vector<WorkMeasurement> measurements(numThreads); // of every helper thread in the current phase
 
-        double startValue = 1.0 / networkSize;
+        auto const &pages = network.getPages();
+        std::vector<std::thread> threads;
         for (uint32_t t = 0; t < numThreads; t++) {
-            std::vector<const Page*> &myPagesToID = managedPagesGenerateId[t];
-            std::vector<PageId> &myPages = managedPages[t];
-            std::vector<PageId> &myDanglingNodes = managedDanglingNodes[t];
-
-            threads.push_back(std::thread{preparePages, std::ref(state),
-                                          std::ref(myPagesToID), std::ref(generator),
-                                          std::ref(myPages), std::ref(myDanglingNodes),
-                                          std::ref(mutex), startValue});
+            threads.push_back(std::thread{[&, t] {
+                WorkProbe probe(instrumented, counted);
+                generatePageIds(pages, pages.size() * t / numThreads, pages.size() * (t + 1) / numThreads,
+                                network.getGenerator());
+                probe.finish(measurements[t]);
+            }});
         }
 
         joinAndClearThreads(threads);
 
-        double danglingWeight = 1.0 / networkSize;
-        double base = (1.0 - alpha) / networkSize;
-
-        for (uint32_t i = 0; i < iterations; ++i) {
-            std::unordered_map<PageId, PageRank, PageIdHash> previousPageHashMap = pageHashMap;
+        std::vector<PageId> ids;
+        ids.reserve(pages.size());
+        size_t numLinks = 0;
+        for (auto const &page : pages) {
+            ids.push_back(page.getId());
+            numLinks += page.getLinks().size();
+        }
+        this->finishPhase("generateIds", phaseStopwatch, measurements);
 
-            double dangleSum = 0;
+        return compileForIds(std::move(ids), NetworkLinks(network), numLinks, phaseStopwatch, measurements);
+    }
 
-            for (uint32_t t = 0; t < numThreads; t++) {
-                std::vector<PageId> &myDanglingNodes = managedDanglingNodes[t];
+    PreparedNetwork prepareNetwork(ArenaNetwork const& network, Stopwatch &phaseStopwatch) const
+    {
+        bool instrumented = this->observer != nullptr;
+        bool counted = instrumented and this->observer->wantsHardwareCounters();
+        std::vector<WorkMeasurement> measurements(numThreads);
 
-                threads.push_back(std::thread{calculateDangleSum,std::ref(previousPageHashMap),
-                                              std::ref(myDanglingNodes), std::ref(dangleSum),
-                                              std::ref(mutex)});
-            }
+        std::vector<PageId> ids(network.getSize(), PageId(""));
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < numThreads; t++) {
+            threads.push_back(std::thread{[&, t] {
+                WorkProbe probe(instrumented, counted);
+                std::string content; // reused, so only the generator allocates
+                for (size_t i = ids.size() * t / numThreads; i < ids.size() * (t + 1) / numThreads; ++i) {
+                    content.assign(network.getContent(i));
+                    ids[i] = network.getGenerator().generateId(content);
+                }
+                probe.finish(measurements[t]);
+            }});
+        }
 
-            joinAndClearThreads(threads);
+        joinAndClearThreads(threads);
+        this->finishPhase("generateIds", phaseStopwatch, measurements);
 
-            dangleSum = dangleSum * alpha;
+        return compileForIds(std::move(ids), network, network.getTotalNumLinks(), phaseStopwatch, measurements);
+    }
 
-            double difference = 0;
-            state.baseValue = dangleSum * danglingWeight + base;
+    template <typename LinkSource>
+    PreparedNetwork compileForIds(std::vector<PageId> &&ids, LinkSource const &links, size_t numLinks,
+                                  Stopwatch &phaseStopwatch, std::vector<WorkMeasurement> &measurements) const
+    {
+        // The tightest index type halves the bandwidth of the in-edge lists for all but huge graphs
+        if (CompiledNetwork<uint32_t>::canIndex(ids.size(), numLinks)) {
+            return compileWithIndex<uint32_t>(std::move(ids), links, phaseStopwatch, measurements);
+        }
+        return compileWithIndex<uint64_t>(std::move(ids), links, phaseStopwatch, measurements);
+    }
 
-            for (uint32_t t = 0; t < numThreads; t++) {
-                std::vector<PageId> &myPages = managedPages[t];
+    template <typename Index, typename LinkSource>
+    PreparedNetwork compileWithIndex(std::vector<PageId> &&ids, LinkSource const &links,
+                                     Stopwatch &phaseStopwatch, std::vector<WorkMeasurement> &measurements) const
+    {
+        bool instrumented = this->observer != nullptr;
+        bool counted = instrumented and this->observer->wantsHardwareCounters();
+        PreparedNetwork prepared(CompiledNetwork<Index>::compile(std::move(ids), links, numThreads, measurements,
+                                                                 instrumented, counted));
+        this->finishPhase("buildGraph", phaseStopwatch, measurements);
+        return prepared;
+    }
 
-                threads.push_back(std::thread{calculatePageRank, std::ref(state),
-                                              std::ref(previousPageHashMap), std::ref(myPages),
-                                              std::ref(mutex), std::ref(difference)});
+    PageRankResult computePrepared(PreparedNetwork const &prepared, double alpha, uint32_t iterations,
+                                   double tolerance, PageRankControl *control, Stopwatch &phaseStopwatch) const
+    {
+        return prepared.visit([&](auto const &compiled) {
+            if (this->singlePrecision) {
+                return dispatchTraits<float>(compiled, alpha, iterations, tolerance, control, phaseStopwatch);
             }
+            return dispatchTraits<double>(compiled, alpha, iterations, tolerance, control, phaseStopwatch);
+        });
+    }
 
-            joinAndClearThreads(threads);
+    template <typename Rank, typename Index>
+    PageRankResult dispatchTraits(CompiledNetwork<Index> const &compiled, double alpha, uint32_t iterations,
+                                  double tolerance, PageRankControl *control, Stopwatch &phaseStopwatch) const
+    {
+        bool hasDanglingNodes = compiled.hasDanglingVertices();
+        bool unweighted = not compiled.isWeighted();
+        if (hasDanglingNodes) {
+            return unweighted
+                   ? iterate<Rank, Index, true, true>(compiled, alpha, iterations, tolerance, control, phaseStopwatch)
+                   : iterate<Rank, Index, true, false>(compiled, alpha, iterations, tolerance, control, phaseStopwatch);
+        }
+        return unweighted
+               ? iterate<Rank, Index, false, true>(compiled, alpha, iterations, tolerance, control, phaseStopwatch)
+               : iterate<Rank, Index, false, false>(compiled, alpha, iterations, tolerance, control, phaseStopwatch);
+    }
 
-            if (difference < tolerance) {
-                std::vector<PageIdAndRank> result;
-                for (auto iter : pageHashMap) {
-                    result.push_back(PageIdAndRank(iter.first, iter.second));
+    template <typename Rank, typename Index, bool HasDanglingNodes, bool Unweighted>
+    PageRankResult iterate(CompiledNetwork<Index> const &compiled, double alpha, uint32_t iterations,
+                           double tolerance, PageRankControl *control, Stopwatch &phaseStopwatch) const
+    {
+        typedef PageRankKernel<Rank, Index, HasDanglingNodes, Unweighted> Kernel;
+        bool instrumented = this->observer != nullptr;
+        bool counted = instrumented and this->observer->wantsHardwareCounters();
+
+        std::vector<Rank> ranks;
+        std::vector<Rank> previousContributions;
+        std::vector<Rank> nextContributions;
+        PageRankIteration<Rank, Index, HasDanglingNodes, Unweighted> iteration(
+                compiled, alpha, ranks, previousContributions, nextContributions);
+
+        std::vector<Index> boundaries = compiled.partition(numThreads);
+        size_t numDanglingVertices = compiled.getDanglingVertices().size();
+        std::vector<SweepResult> sweepResults(numThreads);
+        std::vector<double> dangleSums(numThreads);
+        WorkerPool workers(numThreads, counted);
+
+        double dangleSumSeconds = 0;
+        double rankSweepSeconds = 0;
+        std::vector<WorkMeasurement> dangleSumMeasurements(numThreads);
+        std::vector<WorkMeasurement> rankSweepMeasurements(numThreads);
+
+        for (uint32_t i = 0; iteration.shouldContinue(iterations, control); ++i) {
+            Stopwatch iterationStopwatch(instrumented);
+
+            if (HasDanglingNodes and not fusedIteration and i > 0) {
+                workers.run([&](uint32_t t, HardwareCounters &counters) {
+                    WorkProbe probe(instrumented, counters);
+                    dangleSums[t] = Kernel::danglingSum(compiled, numDanglingVertices * t / numThreads,
+                                                        numDanglingVertices * (t + 1) / numThreads, ranks);
+                    probe.finish(dangleSumMeasurements[t]);
+                });
+                double dangleSum = Kernel::danglingSourcesSum(compiled, iteration.getSourceRank());
+                for (double myDangleSum : dangleSums) {
+                    dangleSum += myDangleSum;
                 }
+                iteration.setDangleSum(dangleSum);
+                dangleSumSeconds += iterationStopwatch.getSeconds();
+            }
 
-                ASSERT(result.size() == network.getSize(), "Invalid result size=" << result.size() << ", for network" << network);
+            Stopwatch rankSweepStopwatch(instrumented);
+            Rank baseValue = iteration.getBaseValue();
+            workers.run([&](uint32_t t, HardwareCounters &counters) {
+                WorkProbe probe(instrumented, counters);
+                sweepResults[t] = iteration.sweep(boundaries[t], boundaries[t + 1], baseValue);
+                probe.finish(rankSweepMeasurements[t]);
+            });
+            rankSweepSeconds += rankSweepStopwatch.getSeconds();
+
+            // Workers are idle between iterations, so control may read the ranks
+            double difference = iteration.finish(baseValue, sweepResults, tolerance, control);
+            if (instrumented) {
+                this->observer->onIterationFinished(i, iterationStopwatch.getSeconds(), difference,
+                                                    compiled.getNumEdges());
+            }
+        }
 
-                return result;
+        if (instrumented) {
+            if (HasDanglingNodes and not fusedIteration) {
+                this->reportPhase("dangleSum", dangleSumSeconds, dangleSumMeasurements);
             }
+            this->reportPhase("rankSweep", rankSweepSeconds, rankSweepMeasurements);
         }
+        phaseStopwatch.restart();
 
-        ASSERT(false, "Not able to find result in iterations=" << iterations);
+        PageRankResult result = iteration.getResult(control);
+        if (instrumented) {
+            this->observer->onPhaseFinished("collectResult", phaseStopwatch.getSeconds());
+        }
+        return result;
     }
 
-    std::string getName() const
+    void reportPhase(std::string const& phase, double seconds, std::vector<WorkMeasurement> const& measurements) const
     {
-        return "MultiThreadedPageRankComputer[" + std::to_string(this->numThreads) + "]";
+        this->observer->onPhaseFinished(phase, seconds);
+        for (uint32_t t = 0; t < numThreads; t++) {
+            double busySeconds = measurements[t].busySeconds;
+            this->observer->onThreadFinished(phase, t, busySeconds, seconds - busySeconds);
+            if (measurements[t].counters.numSamples > 0) {
+                this->observer->onThreadCounters(phase, t, measurements[t].counters);
+            }
+        }
     }
 
-    //todo destruktor moze
+    void finishPhase(std::string const& phase, Stopwatch &stopwatch, std::vector<WorkMeasurement> &measurements) const
+    {
+        if (this->observer != nullptr) {
+            this->reportPhase(phase, stopwatch.getSeconds(), measurements);
+        }
+        std::fill(measurements.begin(), measurements.end(), WorkMeasurement());
+        stopwatch.restart();
+    }
 
-private:
     uint32_t numThreads;
-    mutable std::mutex mutex;
+    // Computes the next dangle sum and the difference in the same sweep that writes new ranks,
+    // so an iteration needs one pass over the pages and one fork/join instead of two
+    bool fusedIteration;
+    // Stores ranks as float instead of double, halving the bandwidth of rank reads
+    bool singlePrecision;
 };
 
 #endif /* SRC_MULTITHREADEDPAGERANKCOMPUTER_HPP_ */
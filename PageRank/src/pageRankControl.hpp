@@ -0,0 +1,136 @@
+#ifndef SRC_PAGERANKCONTROL_HPP_
+#define SRC_PAGERANKCONTROL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "immutable/network.hpp"
+#include "immutable/pageIdAndRank.hpp"
+
+struct PageRankResult {
+    std::vector<PageIdAndRank> ranks;
+    // Iterations actually done
+    uint32_t numIterations;
+    // Sum of absolute rank changes in the last iteration
+    double residual;
+    bool converged;
+    bool cancelled;
+};
+
+struct PageRankProgress {
+    uint32_t numIterations;
+    double residual;
+};
+
+// Ranks after some iteration, taken while the computation goes on
+struct PageRankSnapshot {
+    std::vector<PageIdAndRank> ranks;
+    uint32_t numIterations;
+    double residual;
+};
+
+// Lets another thread follow and steer a running computation. The computer calls
+// onIteration between iterations: cancellation takes effect and snapshots are taken
+// there, so they never wait longer than a single iteration.
+class PageRankControl {
+public:
+    PageRankControl()
+        : cancelled(false)
+        , finished(false)
+        , numIterations(0)
+        , residual(0)
+        , numSnapshotRequests(0)
+        , snapshot { {}, 0, 0 }
+    {
+    }
+
+    // Cooperative: the computation stops after its current iteration and returns what it has
+    void cancel()
+    {
+        this->cancelled = true;
+    }
+
+    bool isCancelled() const
+    {
+        return this->cancelled;
+    }
+
+    PageRankProgress getProgress() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return PageRankProgress { this->numIterations, this->residual };
+    }
+
+    // Blocks until the end of the current iteration. Returns false (and no ranks) when
+    // the computation finished without taking the snapshot.
+    bool takeSnapshot(PageRankSnapshot& snapshot)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->finished) {
+            return false;
+        }
+
+        uint32_t requestedAfter = this->numIterations;
+        ++this->numSnapshotRequests;
+        this->snapshotTaken.wait(lock, [&] {
+            return this->finished or this->snapshot.numIterations > requestedAfter;
+        });
+        --this->numSnapshotRequests;
+
+        if (this->snapshot.numIterations <= requestedAfter) {
+            return false;
+        }
+        snapshot = this->snapshot;
+        return true;
+    }
+
+    // Called by the computer after every iteration. collectRanks is invoked only when
+    // somebody waits for a snapshot, so following the progress costs almost nothing.
+    void onIteration(uint32_t numIterationsArg, double residualArg,
+        std::function<std::vector<PageIdAndRank>()> const& collectRanks)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->numIterations = numIterationsArg;
+        this->residual = residualArg;
+        if (this->numSnapshotRequests > 0) {
+            this->snapshot = PageRankSnapshot { collectRanks(), numIterationsArg, residualArg };
+            this->snapshotTaken.notify_all();
+        }
+    }
+
+    // Called by the computer when it returns, wakes up everybody waiting for a snapshot
+    void onFinished()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->finished = true;
+        this->snapshotTaken.notify_all();
+    }
+
+private:
+    std::atomic<bool> cancelled;
+    mutable std::mutex mutex;
+    std::condition_variable snapshotTaken;
+    bool finished;
+    uint32_t numIterations;
+    double residual;
+    uint32_t numSnapshotRequests;
+    // Latest one taken, numIterations is 0 until then
+    PageRankSnapshot snapshot;
+};
+
+// Mixed into the computers which can be followed and stopped with a PageRankControl,
+// next to PageRankComputer
+class PageRankControllable {
+public:
+    // Like computeForNetwork, but returns with the ranks reached so far when it runs out of
+    // iterations or control gets cancelled, instead of failing. Control may be nullptr.
+    virtual PageRankResult computeWithControl(Network const& network, double alpha, uint32_t iterations,
+        double tolerance, PageRankControl* control) const = 0;
+
+    virtual ~PageRankControllable() { }
+};
+
+#endif /* SRC_PAGERANKCONTROL_HPP_ */
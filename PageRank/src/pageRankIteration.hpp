@@ -0,0 +1,120 @@
+#ifndef SRC_PAGERANKITERATION_HPP_
+#define SRC_PAGERANKITERATION_HPP_
+
+#include <limits>
+#include <vector>
+
+#include "compiledNetwork.hpp"
+#include "pageRankControl.hpp"
+#include "pageRankKernel.hpp"
+
+// Pulling power iteration of a CompiledNetwork with PageRankKernel, shared by
+// MultiThreadedPageRankComputer and BatchPageRankComputer, which differ only in how
+// the sweeps of an iteration run. Every iteration takes getBaseValue(), sweeps all
+// core vertices in parts (concurrently or not) and passes their results to finish.
+// Buffers are given by the caller, so that they can be kept from network to network.
+template <typename Rank, typename Index, bool HasDanglingNodes, bool Unweighted>
+class PageRankIteration {
+public:
+    typedef PageRankKernel<Rank, Index, HasDanglingNodes, Unweighted> Kernel;
+
+    // Starts from the uniform vector
+    PageRankIteration(CompiledNetwork<Index> const& networkArg, double alphaArg, std::vector<Rank>& ranksArg,
+        std::vector<Rank>& previousContributionsArg, std::vector<Rank>& nextContributionsArg)
+        : network(networkArg)
+        , alpha(alphaArg)
+        , ranks(ranksArg)
+        , previousContributions(previousContributionsArg)
+        , nextContributions(nextContributionsArg)
+        , numIterations(0)
+        , difference(std::numeric_limits<double>::infinity())
+        , converged(false)
+    {
+        this->dangleSum = Kernel::initialize(this->network, this->alpha, this->ranks, this->previousContributions,
+            this->sourceRank);
+        this->nextContributions.resize(this->network.getNumCoreVertices());
+    }
+
+    // Whether another iteration should run; a cancelled control stops before it
+    bool shouldContinue(uint32_t iterations, PageRankControl* control) const
+    {
+        return this->numIterations < iterations and not this->converged
+            and not (control != nullptr and control->isCancelled());
+    }
+
+    Rank getBaseValue() const
+    {
+        return Kernel::getBaseValue(this->network, this->alpha, this->dangleSum);
+    }
+
+    // Sweeps of disjoint ranges of an iteration may run concurrently
+    SweepResult sweep(Index begin, Index end, Rank baseValue)
+    {
+        return Kernel::sweep(this->network, begin, end, this->alpha, baseValue, this->sourceRank,
+            this->previousContributions, this->ranks, this->nextContributions);
+    }
+
+    // For iterations that sum up ranks of dangling vertices in a pass of their own, before getBaseValue
+    void setDangleSum(double dangleSumArg)
+    {
+        this->dangleSum = dangleSumArg;
+    }
+
+    // Must follow the sweeps of all parts. Accounts for sources and reports the iteration to control.
+    double finish(Rank baseValue, std::vector<SweepResult> const& results, double tolerance, PageRankControl* control)
+    {
+        this->previousContributions.swap(this->nextContributions);
+        SweepResult sourcesResult = Kernel::sweepSources(this->network, baseValue, this->sourceRank);
+        this->difference = sourcesResult.difference;
+        this->dangleSum = sourcesResult.danglingSum;
+        for (auto const& result : results) {
+            this->difference += result.difference;
+            this->dangleSum += result.danglingSum;
+        }
+
+        ++this->numIterations;
+        this->converged = this->difference < tolerance;
+        if (control != nullptr) {
+            // Sweeps are done between iterations, so ranks can be read without stopping them
+            control->onIteration(this->numIterations, this->difference,
+                [this] { return this->network.collectRanks(this->ranks, this->sourceRank); });
+        }
+        return this->difference;
+    }
+
+    std::vector<Rank> const& getRanks() const
+    {
+        return this->ranks;
+    }
+
+    Rank getSourceRank() const
+    {
+        return this->sourceRank;
+    }
+
+    // Ranks of all pages after the last iteration, control is told that the computation is over
+    PageRankResult getResult(PageRankControl* control) const
+    {
+        std::vector<PageIdAndRank> result = this->network.collectRanks(this->ranks, this->sourceRank);
+        if (control != nullptr) {
+            control->onFinished();
+        }
+        bool cancelled = not this->converged and control != nullptr and control->isCancelled();
+        return PageRankResult { std::move(result), this->numIterations, this->difference, this->converged, cancelled };
+    }
+
+private:
+    CompiledNetwork<Index> const& network;
+    double alpha;
+    std::vector<Rank>& ranks;
+    std::vector<Rank>& previousContributions;
+    std::vector<Rank>& nextContributions;
+    Rank sourceRank;
+    // Of the current ranks, sources included
+    double dangleSum;
+    uint32_t numIterations;
+    double difference;
+    bool converged;
+};
+
+#endif /* SRC_PAGERANKITERATION_HPP_ */
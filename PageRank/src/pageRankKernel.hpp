@@ -0,0 +1,157 @@
+#ifndef SRC_PAGERANKKERNEL_HPP_
+#define SRC_PAGERANKKERNEL_HPP_
+
+#include <cmath>
+#include <vector>
+
+#include "compiledNetwork.hpp"
+
+struct SweepResult {
+    SweepResult()
+        : difference(0)
+        , danglingSum(0)
+    {
+    }
+
+    // Sum of absolute rank changes of the swept vertices
+    double difference;
+    // Sum of new ranks of the swept dangling vertices
+    double danglingSum;
+};
+
+// Power iteration over the core of a CompiledNetwork, specialized at compile time for:
+//  - Rank: type of stored ranks (float halves the bandwidth, at the cost of precision),
+//  - Index: vertex and edge index type of the network,
+//  - HasDanglingNodes: without dangling vertices the dangling sum is never computed,
+//  - Unweighted: without duplicate links edge weights are never read.
+// Every vertex v publishes contribution[v] = alpha * rank[v] / outDegree[v], so a sweep
+// only sums up contributions of in-edge sources. Sweeps of disjoint vertex ranges may
+// run concurrently: they read previous contributions and write their own vertices only.
+// Pages without in-links share a single sourceRank, which sweepSources advances once
+// the core sweeps of an iteration are done.
+template <typename Rank, typename Index, bool HasDanglingNodes, bool Unweighted>
+class PageRankKernel {
+public:
+    // Uniform start vector, returns its dangling sum
+    static double initialize(CompiledNetwork<Index> const& network, double alpha, std::vector<Rank>& ranks,
+        std::vector<Rank>& contributions, Rank& sourceRank)
+    {
+        Index numVertices = network.getNumCoreVertices();
+        Rank startValue = static_cast<Rank>(1.0 / network.getNumVertices());
+        ranks.assign(numVertices, startValue);
+        contributions.resize(numVertices);
+        for (Index v = 0; v < numVertices; ++v) {
+            contributions[v] = contribution(network, v, startValue, static_cast<Rank>(alpha));
+        }
+        sourceRank = startValue;
+
+        if constexpr (HasDanglingNodes) {
+            return static_cast<double>(startValue)
+                * (network.getDanglingVertices().size() + network.getNumDanglingSources());
+        }
+        return 0;
+    }
+
+    // Rank every page gets regardless of its in-edges: teleport plus evenly spread dangling ranks
+    static Rank getBaseValue(CompiledNetwork<Index> const& network, double alpha, double danglingSum)
+    {
+        double numVertices = network.getNumVertices();
+        if constexpr (HasDanglingNodes) {
+            return static_cast<Rank>((1.0 - alpha) / numVertices + alpha * danglingSum / numVertices);
+        }
+        return static_cast<Rank>((1.0 - alpha) / numVertices);
+    }
+
+    // New ranks of core vertices [begin, end) and their contributions to the next iteration,
+    // sourceRank is the rank of sources in the previous iteration
+    static SweepResult sweep(CompiledNetwork<Index> const& network, Index begin, Index end, double alpha,
+        Rank baseValue, Rank sourceRank, std::vector<Rank> const& previousContributions, std::vector<Rank>& ranks,
+        std::vector<Rank>& nextContributions)
+    {
+        Index const* inOffsets = network.getInOffsets().data();
+        Index const* inSources = network.getInSources().data();
+        Index const* inWeights = network.getInWeights().data();
+        double const* sourceWeights = network.getSourceWeights().empty() ? nullptr : network.getSourceWeights().data();
+        Rank const* previous = previousContributions.data();
+        Rank rankAlpha = static_cast<Rank>(alpha);
+        Rank sourceContribution = rankAlpha * sourceRank;
+
+        SweepResult result;
+        for (Index v = begin; v < end; ++v) {
+            Rank sum = 0;
+            for (Index edge = inOffsets[v]; edge < inOffsets[v + 1]; ++edge) {
+                if constexpr (Unweighted) {
+                    sum += previous[inSources[edge]];
+                } else {
+                    sum += previous[inSources[edge]] * static_cast<Rank>(inWeights[edge]);
+                }
+            }
+
+            if (sourceWeights != nullptr) {
+                sum += sourceContribution * static_cast<Rank>(sourceWeights[v]);
+            }
+
+            Rank newRank = baseValue + sum;
+            result.difference += std::abs(static_cast<double>(newRank) - static_cast<double>(ranks[v]));
+            ranks[v] = newRank;
+            if constexpr (HasDanglingNodes) {
+                if (network.getOutDegrees()[v] == 0) {
+                    result.danglingSum += newRank;
+                }
+            }
+            nextContributions[v] = contribution(network, v, newRank, rankAlpha);
+        }
+        return result;
+    }
+
+    // Sources rank exactly the base value, this accounts for all of them at once.
+    // Must follow the sweeps of the iteration, which read the previous sourceRank.
+    static SweepResult sweepSources(CompiledNetwork<Index> const& network, Rank baseValue, Rank& sourceRank)
+    {
+        SweepResult result;
+        result.difference = std::abs(static_cast<double>(baseValue) - static_cast<double>(sourceRank))
+            * network.getNumSources();
+        if constexpr (HasDanglingNodes) {
+            result.danglingSum = static_cast<double>(baseValue) * network.getNumDanglingSources();
+        }
+        sourceRank = baseValue;
+        return result;
+    }
+
+    // Sum of ranks of dangling vertices [begin, end) of network.getDanglingVertices()
+    static double danglingSum(CompiledNetwork<Index> const& network, size_t begin, size_t end,
+        std::vector<Rank> const& ranks)
+    {
+        double sum = 0;
+        if constexpr (HasDanglingNodes) {
+            auto const& danglingVertices = network.getDanglingVertices();
+            for (size_t i = begin; i < end; ++i) {
+                sum += ranks[danglingVertices[i]];
+            }
+        }
+        return sum;
+    }
+
+    // Sum of ranks of sources without out-links
+    static double danglingSourcesSum(CompiledNetwork<Index> const& network, Rank sourceRank)
+    {
+        if constexpr (HasDanglingNodes) {
+            return static_cast<double>(sourceRank) * network.getNumDanglingSources();
+        }
+        return 0;
+    }
+
+private:
+    static Rank contribution(CompiledNetwork<Index> const& network, Index v, Rank rank, Rank alpha)
+    {
+        Index outDegree = network.getOutDegrees()[v];
+        if constexpr (HasDanglingNodes) {
+            if (outDegree == 0) {
+                return 0;
+            }
+        }
+        return alpha * rank / static_cast<Rank>(outDegree);
+    }
+};
+
+#endif /* SRC_PAGERANKKERNEL_HPP_ */
@@ -0,0 +1,37 @@
+#ifndef SRC_PAGERANKOBSERVABLE_HPP_
+#define SRC_PAGERANKOBSERVABLE_HPP_
+
+#include "immutable/pageRankComputer.hpp"
+#include "pageRankObserver.hpp"
+
+// Mixed into the computers which report to a PageRankObserver, next to PageRankComputer
+class PageRankObservable {
+public:
+    PageRankObservable()
+        : observer(nullptr)
+    {
+    }
+
+    // Observer is notified about every following computation, nullptr turns instrumentation off
+    void setObserver(PageRankObserver* observerArg)
+    {
+        this->observer = observerArg;
+    }
+
+    // For code holding just a PageRankComputer: sets its observer if it has one, returns whether it has
+    static bool setObserverOf(PageRankComputer& computer, PageRankObserver* observer)
+    {
+        PageRankObservable* observable = dynamic_cast<PageRankObservable*>(&computer);
+        if (observable != nullptr) {
+            observable->setObserver(observer);
+        }
+        return observable != nullptr;
+    }
+
+    virtual ~PageRankObservable() { }
+
+protected:
+    PageRankObserver* observer;
+};
+
+#endif /* SRC_PAGERANKOBSERVABLE_HPP_ */
@@ -0,0 +1,76 @@
+#ifndef SRC_PAGERANKOBSERVER_HPP_
+#define SRC_PAGERANKOBSERVER_HPP_
+
+#include <cstdint>
+#include <string>
+
+// Hardware counters summed over one or more measured pieces of work
+struct HardwareCounterValues {
+    enum Counter {
+        CYCLES,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        NUM_COUNTERS
+    };
+
+    HardwareCounterValues()
+        : numSamples(0)
+        , values {}
+        , available {}
+    {
+    }
+
+    HardwareCounterValues& operator+=(HardwareCounterValues const& other)
+    {
+        if (other.numSamples > 0) {
+            for (uint32_t counter = 0; counter < NUM_COUNTERS; ++counter) {
+                this->values[counter] += other.values[counter];
+                this->available[counter] = (this->numSamples == 0 or this->available[counter]) and other.available[counter];
+            }
+            this->numSamples += other.numSamples;
+        }
+        return *this;
+    }
+
+    static char const* getName(Counter counter)
+    {
+        static char const* const names[NUM_COUNTERS] = { "cycles", "instructions", "llcMisses", "branchMisses" };
+        return names[counter];
+    }
+
+    uint32_t numSamples;
+    uint64_t values[NUM_COUNTERS];
+    // A counter is available only if it could be read in every sample
+    bool available[NUM_COUNTERS];
+};
+
+// Receives instrumentation of a PageRankComputer. All callbacks are invoked from
+// the thread which called computeForNetwork, never from helper threads.
+class PageRankObserver {
+public:
+    virtual void onComputationStarted(std::string const& /* computerName */, size_t /* numPages */) { }
+
+    // Phases are e.g. generateIds, buildGraph, copyRanks, dangleSum, rankSweep, collectResult.
+    // Phases repeated every iteration are reported once, summed over all iterations.
+    virtual void onPhaseFinished(std::string const& /* phase */, double /* seconds */) { }
+
+    virtual void onIterationFinished(uint32_t /* iteration */, double /* seconds */, double /* difference */,
+        uint64_t /* edgesProcessed */) { }
+
+    // Wait time is the part of the phase a thread spent not doing its own work,
+    // i.e. blocked on locks or waiting for other threads to finish
+    virtual void onThreadFinished(std::string const& /* phase */, uint32_t /* thread */, double /* busySeconds */,
+        double /* waitSeconds */) { }
+
+    // Hardware counters cost a few syscalls per thread and phase, so they are only
+    // collected for observers which ask for them
+    virtual bool wantsHardwareCounters() const { return false; }
+
+    virtual void onThreadCounters(std::string const& /* phase */, uint32_t /* thread */,
+        HardwareCounterValues const& /* counters */) { }
+
+    virtual ~PageRankObserver() { }
+};
+
+#endif /* SRC_PAGERANKOBSERVER_HPP_ */
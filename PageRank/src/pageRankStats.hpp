@@ -0,0 +1,235 @@
+#ifndef SRC_PAGERANKSTATS_HPP_
+#define SRC_PAGERANKSTATS_HPP_
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "pageRankObserver.hpp"
+
+// Observer remembering everything reported about the last computation
+class PageRankStats : public PageRankObserver {
+public:
+    struct Phase {
+        std::string name;
+        double seconds;
+    };
+
+    struct Iteration {
+        uint32_t iteration;
+        double seconds;
+        double difference;
+        uint64_t edgesProcessed;
+    };
+
+    struct Thread {
+        std::string phase;
+        uint32_t thread;
+        double busySeconds;
+        double waitSeconds;
+    };
+
+    struct ThreadCounters {
+        std::string phase;
+        uint32_t thread;
+        HardwareCounterValues counters;
+    };
+
+    // Hardware counters are opt-in: reading them costs a few syscalls per thread and phase
+    PageRankStats(bool hardwareCountersArg = false)
+        : hardwareCounters(hardwareCountersArg)
+        , numPages(0)
+    {
+    }
+
+    virtual void onComputationStarted(std::string const& computerNameArg, size_t numPagesArg)
+    {
+        this->computerName = computerNameArg;
+        this->numPages = numPagesArg;
+        this->phases.clear();
+        this->iterations.clear();
+        this->threads.clear();
+        this->threadCounters.clear();
+    }
+
+    virtual void onPhaseFinished(std::string const& phase, double seconds)
+    {
+        this->phases.push_back(Phase { phase, seconds });
+    }
+
+    virtual void onIterationFinished(uint32_t iteration, double seconds, double difference, uint64_t edgesProcessed)
+    {
+        this->iterations.push_back(Iteration { iteration, seconds, difference, edgesProcessed });
+    }
+
+    virtual void onThreadFinished(std::string const& phase, uint32_t thread, double busySeconds, double waitSeconds)
+    {
+        this->threads.push_back(Thread { phase, thread, busySeconds, waitSeconds });
+    }
+
+    virtual bool wantsHardwareCounters() const
+    {
+        return this->hardwareCounters;
+    }
+
+    virtual void onThreadCounters(std::string const& phase, uint32_t thread, HardwareCounterValues const& counters)
+    {
+        this->threadCounters.push_back(ThreadCounters { phase, thread, counters });
+    }
+
+    std::vector<Phase> const& getPhases() const
+    {
+        return this->phases;
+    }
+
+    std::vector<Iteration> const& getIterations() const
+    {
+        return this->iterations;
+    }
+
+    std::vector<Thread> const& getThreads() const
+    {
+        return this->threads;
+    }
+
+    std::vector<ThreadCounters> const& getThreadCounters() const
+    {
+        return this->threadCounters;
+    }
+
+    // Sum over all threads, numSamples is 0 if nothing was counted in the phase
+    HardwareCounterValues getPhaseCounters(std::string const& phase) const
+    {
+        HardwareCounterValues counters;
+        for (auto const& thread : this->threadCounters) {
+            if (thread.phase == phase) {
+                counters += thread.counters;
+            }
+        }
+        return counters;
+    }
+
+    // Negative when the counters are not available
+    static double getInstructionsPerCycle(HardwareCounterValues const& counters)
+    {
+        if (counters.numSamples == 0 or not counters.available[HardwareCounterValues::CYCLES]
+            or not counters.available[HardwareCounterValues::INSTRUCTIONS] or counters.values[HardwareCounterValues::CYCLES] == 0) {
+            return -1;
+        }
+        return static_cast<double>(counters.values[HardwareCounterValues::INSTRUCTIONS]) / counters.values[HardwareCounterValues::CYCLES];
+    }
+
+    // Of the rank sweeps, where all the edges are processed; negative when not available
+    double getLlcMissesPerEdge() const
+    {
+        HardwareCounterValues counters = this->getPhaseCounters("rankSweep");
+        uint64_t edgesProcessed = this->getEdgesProcessed();
+        if (counters.numSamples == 0 or not counters.available[HardwareCounterValues::LLC_MISSES] or edgesProcessed == 0) {
+            return -1;
+        }
+        return static_cast<double>(counters.values[HardwareCounterValues::LLC_MISSES]) / edgesProcessed;
+    }
+
+    uint64_t getEdgesProcessed() const
+    {
+        uint64_t edgesProcessed = 0;
+        for (auto const& iteration : this->iterations) {
+            edgesProcessed += iteration.edgesProcessed;
+        }
+        return edgesProcessed;
+    }
+
+    void writeJson(std::ostream& out) const
+    {
+        auto precision = out.precision(9);
+
+        out << "{\"computer\": \"" << this->computerName << "\", \"numPages\": " << this->numPages;
+
+        out << ", \"phases\": [";
+        for (size_t i = 0; i < this->phases.size(); ++i) {
+            out << (i > 0 ? ", " : "") << "{\"name\": \"" << this->phases[i].name
+                << "\", \"seconds\": " << this->phases[i].seconds << "}";
+        }
+
+        out << "], \"iterations\": [";
+        for (size_t i = 0; i < this->iterations.size(); ++i) {
+            auto const& iteration = this->iterations[i];
+            out << (i > 0 ? ", " : "") << "{\"iteration\": " << iteration.iteration
+                << ", \"seconds\": " << iteration.seconds << ", \"difference\": " << iteration.difference
+                << ", \"edgesProcessed\": " << iteration.edgesProcessed << "}";
+        }
+
+        out << "], \"threads\": [";
+        for (size_t i = 0; i < this->threads.size(); ++i) {
+            auto const& thread = this->threads[i];
+            out << (i > 0 ? ", " : "") << "{\"phase\": \"" << thread.phase << "\", \"thread\": " << thread.thread
+                << ", \"busySeconds\": " << thread.busySeconds << ", \"waitSeconds\": " << thread.waitSeconds << "}";
+        }
+        out << "]";
+
+        if (this->hardwareCounters) {
+            out << ", \"threadCounters\": [";
+            for (size_t i = 0; i < this->threadCounters.size(); ++i) {
+                auto const& thread = this->threadCounters[i];
+                out << (i > 0 ? ", " : "") << "{\"phase\": \"" << thread.phase << "\", \"thread\": " << thread.thread;
+                writeCounters(out, thread.counters);
+                out << "}";
+            }
+
+            // Phases in order of their first appearance
+            out << "], \"phaseCounters\": [";
+            std::vector<std::string> countedPhases;
+            for (auto const& thread : this->threadCounters) {
+                if (std::find(countedPhases.begin(), countedPhases.end(), thread.phase) == countedPhases.end()) {
+                    countedPhases.push_back(thread.phase);
+                }
+            }
+            for (size_t i = 0; i < countedPhases.size(); ++i) {
+                out << (i > 0 ? ", " : "") << "{\"phase\": \"" << countedPhases[i] << "\"";
+                writeCounters(out, this->getPhaseCounters(countedPhases[i]));
+                out << "}";
+            }
+            out << "], \"llcMissesPerEdge\": ";
+            writeOptional(out, this->getLlcMissesPerEdge());
+        }
+        out << "}";
+
+        out.precision(precision);
+    }
+
+private:
+    // Unavailable counters are written as null
+    static void writeCounters(std::ostream& out, HardwareCounterValues const& counters)
+    {
+        for (uint32_t counter = 0; counter < HardwareCounterValues::NUM_COUNTERS; ++counter) {
+            out << ", \"" << HardwareCounterValues::getName(static_cast<HardwareCounterValues::Counter>(counter)) << "\": ";
+            if (counters.available[counter]) {
+                out << counters.values[counter];
+            } else {
+                out << "null";
+            }
+        }
+        out << ", \"ipc\": ";
+        writeOptional(out, getInstructionsPerCycle(counters));
+    }
+
+    static void writeOptional(std::ostream& out, double value)
+    {
+        if (value >= 0) {
+            out << value;
+        } else {
+            out << "null";
+        }
+    }
+
+    bool hardwareCounters;
+    std::string computerName;
+    size_t numPages;
+    std::vector<Phase> phases;
+    std::vector<Iteration> iterations;
+    std::vector<Thread> threads;
+    std::vector<ThreadCounters> threadCounters;
+};
+
+#endif /* SRC_PAGERANKSTATS_HPP_ */
@@ -0,0 +1,91 @@
+#ifndef SRC_PAGERANKTASK_HPP_
+#define SRC_PAGERANKTASK_HPP_
+
+#include <chrono>
+#include <future>
+#include <memory>
+
+#include "immutable/network.hpp"
+#include "pageRankControl.hpp"
+
+// Handle of a computation running in the background. A service can poll its residual,
+// take snapshots of the current ranks, cancel it, and collect the result, which is
+// returned also when the computation did not converge. Destroying the handle cancels
+// the computation and waits for it to stop.
+class PageRankTask {
+public:
+    // The computer and the network must outlive the task
+    static PageRankTask start(PageRankControllable const& computer, Network const& network, double alpha,
+        uint32_t iterations, double tolerance)
+    {
+        auto control = std::make_shared<PageRankControl>();
+        std::shared_future<PageRankResult> result = std::async(std::launch::async, [&computer, &network, alpha,
+                                                                  iterations, tolerance, control] {
+            return computer.computeWithControl(network, alpha, iterations, tolerance, control.get());
+        }).share();
+        return PageRankTask(control, result);
+    }
+
+    PageRankTask(PageRankTask&&) = default;
+    PageRankTask& operator=(PageRankTask&&) = default;
+
+    ~PageRankTask()
+    {
+        if (this->control) {
+            this->control->cancel();
+        }
+    }
+
+    // The computation stops after its current iteration
+    void cancel()
+    {
+        this->control->cancel();
+    }
+
+    PageRankProgress getProgress() const
+    {
+        return this->control->getProgress();
+    }
+
+    bool isFinished() const
+    {
+        return this->waitFor(std::chrono::seconds(0));
+    }
+
+    // Returns whether the computation finished within timeout
+    template <typename Rep, typename Period>
+    bool waitFor(std::chrono::duration<Rep, Period> const& timeout) const
+    {
+        return this->result.wait_for(timeout) == std::future_status::ready;
+    }
+
+    // Ranks after the iteration in progress, or the final ones when the computation is over
+    PageRankSnapshot getSnapshot() const
+    {
+        PageRankSnapshot snapshot;
+        if (not this->isFinished() and this->control->takeSnapshot(snapshot)) {
+            return snapshot;
+        }
+
+        PageRankResult const& finalResult = this->result.get();
+        return PageRankSnapshot { finalResult.ranks, finalResult.numIterations, finalResult.residual };
+    }
+
+    // Waits for the computation to stop
+    PageRankResult const& get() const
+    {
+        return this->result.get();
+    }
+
+private:
+    PageRankTask(std::shared_ptr<PageRankControl> const& controlArg, std::shared_future<PageRankResult> const& resultArg)
+        : control(controlArg)
+        , result(resultArg)
+    {
+    }
+
+    std::shared_ptr<PageRankControl> control;
+    std::shared_future<PageRankResult> result;
+};
+
+#endif /* SRC_PAGERANKTASK_HPP_ */
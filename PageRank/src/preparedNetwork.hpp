@@ -0,0 +1,54 @@
+#ifndef SRC_PREPAREDNETWORK_HPP_
+#define SRC_PREPAREDNETWORK_HPP_
+
+#include <memory>
+
+#include "compiledNetwork.hpp"
+
+// Network with generated ids and a compiled graph, as returned by
+// MultiThreadedPageRankComputer::prepare. It is immutable and does not refer to the
+// network it was prepared from, so it can be kept around, copied cheaply (copies share
+// the graph) and computed on from many threads at once with different alpha,
+// iterations and tolerance.
+class PreparedNetwork {
+public:
+    explicit PreparedNetwork(CompiledNetwork<uint32_t>&& compiled)
+        : narrow(std::make_shared<CompiledNetwork<uint32_t> const>(std::move(compiled)))
+    {
+    }
+
+    explicit PreparedNetwork(CompiledNetwork<uint64_t>&& compiled)
+        : wide(std::make_shared<CompiledNetwork<uint64_t> const>(std::move(compiled)))
+    {
+    }
+
+    size_t getSize() const
+    {
+        return this->narrow ? this->narrow->getNumVertices() : this->wide->getNumVertices();
+    }
+
+    // Pages iterated over, the others have no in-links and are computed analytically
+    size_t getNumCoreVertices() const
+    {
+        return this->narrow ? this->narrow->getNumCoreVertices() : this->wide->getNumCoreVertices();
+    }
+
+    size_t getNumEdges() const
+    {
+        return this->narrow ? this->narrow->getNumEdges() : this->wide->getNumEdges();
+    }
+
+    // Calls visitor with the compiled graph, whichever index type it has
+    template <typename Visitor>
+    auto visit(Visitor&& visitor) const
+    {
+        return this->narrow ? visitor(*this->narrow) : visitor(*this->wide);
+    }
+
+private:
+    // Exactly one of them is set
+    std::shared_ptr<CompiledNetwork<uint32_t> const> narrow;
+    std::shared_ptr<CompiledNetwork<uint64_t> const> wide;
+};
+
+#endif /* SRC_PREPAREDNETWORK_HPP_ */
@@ -33,7 +33,7 @@ public:
 
         fgets(idBuffer, HASH_LENGTH + 1, resultFile);
 
-        fclose(resultFile);
+        pclose(resultFile);
 
         command = "rm " + tempFilename;
         std::system(command.data());
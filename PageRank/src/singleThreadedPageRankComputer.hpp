@@ -1,6 +1,7 @@
 #ifndef SRC_SINGLETHREADEDPAGERANKCOMPUTER_HPP_
 #define SRC_SINGLETHREADEDPAGERANKCOMPUTER_HPP_
 
+#include <limits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -8,53 +9,98 @@
 #include "immutable/network.hpp"
 #include "immutable/pageIdAndRank.hpp"
 #include "immutable/pageRankComputer.hpp"
+#include "hardwareCounters.hpp"
+#include "pageRankControl.hpp"
+#include "pageRankObservable.hpp"
+#include "stopwatch.hpp"
 
-class SingleThreadedPageRankComputer : public PageRankComputer {
+class SingleThreadedPageRankComputer : public PageRankComputer, public PageRankControllable, public PageRankObservable {
 public:
     SingleThreadedPageRankComputer() {};
 
     std::vector<PageIdAndRank> computeForNetwork(Network const& network, double alpha,
                                                  uint32_t iterations, double tolerance) const
     {
+        PageRankResult result = this->computeWithControl(network, alpha, iterations, tolerance, nullptr);
+        ASSERT(result.converged, "Not able to find result in iterations=" << iterations);
+        return std::move(result.ranks);
+    }
+
+    PageRankResult computeWithControl(Network const& network, double alpha, uint32_t iterations,
+                                      double tolerance, PageRankControl* control) const
+    {
+        bool instrumented = this->observer != nullptr;
+        if (instrumented) {
+            this->observer->onComputationStarted(this->getName(), network.getSize());
+        }
+        // Opened once for the whole computation, every phase of every iteration reads its part
+        HardwareCounters counters(instrumented and this->observer->wantsHardwareCounters());
+
+        WorkProbe generateIdsProbe(instrumented, counters);
+        for (auto const& page : network.getPages()) {
+            if (not page.isIdGenerated()) {
+                page.generateId(network.getGenerator());
+            }
+        }
+        this->finishPhase("generateIds", generateIdsProbe);
+
+        WorkProbe buildGraphProbe(instrumented, counters);
         std::unordered_map<PageId, PageRank, PageIdHash> pageHashMap;
         size_t networkSize = network.getSize();
         for (auto const& page : network.getPages()) {
-            page.generateId(network.getGenerator());
             pageHashMap[page.getId()] = 1.0 / networkSize;
         }
 
         std::unordered_map<PageId, uint32_t, PageIdHash> numLinks;
-        for (auto page : network.getPages()) {
+        for (auto const& page : network.getPages()) {
             numLinks[page.getId()] = page.getLinks().size();
         }
 
         std::unordered_set<PageId, PageIdHash> danglingNodes;
-        for (auto page : network.getPages()) {
+        for (auto const& page : network.getPages()) {
             if (page.getLinks().size() == 0) {
                 danglingNodes.insert(page.getId());
             }
         }
 
         std::unordered_map<PageId, std::vector<PageId>, PageIdHash> edges;
-        for (auto page : network.getPages()) {
-            for (auto link : page.getLinks()) {
+        for (auto const& page : network.getPages()) {
+            for (auto const& link : page.getLinks()) {
                 edges[link].push_back(page.getId());
             }
         }
+        this->finishPhase("buildGraph", buildGraphProbe);
+
+        WorkMeasurement copyRanksMeasurement;
+        WorkMeasurement dangleSumMeasurement;
+        WorkMeasurement rankSweepMeasurement;
         double danglingWeight = 1.0 / networkSize;
         double base = (1.0 - alpha) / networkSize;
-        for (uint32_t i = 0; i < iterations; ++i) {
+        uint32_t numIterations = 0;
+        double difference = std::numeric_limits<double>::infinity();
+        bool converged = false;
+        for (uint32_t i = 0; i < iterations and not converged; ++i) {
+            if (control != nullptr and control->isCancelled()) {
+                break;
+            }
+
+            Stopwatch iterationStopwatch(instrumented);
+            WorkProbe copyRanksProbe(instrumented, counters);
             std::unordered_map<PageId, PageRank, PageIdHash> previousPageHashMap = pageHashMap;
+            copyRanksProbe.finish(copyRanksMeasurement);
 
+            WorkProbe dangleSumProbe(instrumented, counters);
             double dangleSum = 0;
-            for (auto danglingNode : danglingNodes) {
+            for (auto const& danglingNode : danglingNodes) {
                 dangleSum += previousPageHashMap[danglingNode];
             }
             dangleSum = dangleSum * alpha;
+            dangleSumProbe.finish(dangleSumMeasurement);
 
-
+            WorkProbe rankSweepProbe(instrumented, counters);
             double baseValue = dangleSum * danglingWeight + base;
-            double difference = 0;
+            difference = 0;
+            uint64_t edgesProcessed = 0;
 
             for (auto& pageMapElem : pageHashMap) {
                 PageId pageId = pageMapElem.first;
@@ -62,33 +108,78 @@ public:
                 pageMapElem.second = baseValue;
 
                 if (edges.count(pageId) > 0) {
-                    for (auto link : edges[pageId]) {
+                    for (auto const& link : edges[pageId]) {
                         pageMapElem.second += alpha * previousPageHashMap[link] / numLinks[link];
                     }
+                    edgesProcessed += edges[pageId].size();
                 }
                 difference += std::abs(previousPageHashMap[pageId] - pageMapElem.second);
             }
+            rankSweepProbe.finish(rankSweepMeasurement);
 
+            if (instrumented) {
+                this->observer->onIterationFinished(i, iterationStopwatch.getSeconds(), difference, edgesProcessed);
+            }
 
-            if (difference < tolerance) {
-                std::vector<PageIdAndRank> result;
-                for (auto iter : pageHashMap) {
-                    result.push_back(PageIdAndRank(iter.first, iter.second));
-                }
-
-                ASSERT(result.size() == networkSize, "Invalid result size=" << result.size() << ", for network" << network);
-
-                return result;
+            numIterations = i + 1;
+            converged = difference < tolerance;
+            if (control != nullptr) {
+                control->onIteration(numIterations, difference, [&] { return collectRanks(pageHashMap); });
             }
         }
 
-        ASSERT(false, "Not able to find result in iterations=" << iterations);
+        if (instrumented) {
+            this->reportPhase("copyRanks", copyRanksMeasurement);
+            this->reportPhase("dangleSum", dangleSumMeasurement);
+            this->reportPhase("rankSweep", rankSweepMeasurement);
+        }
+
+        WorkProbe collectResultProbe(instrumented, counters);
+        std::vector<PageIdAndRank> result = collectRanks(pageHashMap);
+        ASSERT(result.size() == networkSize, "Invalid result size=" << result.size() << ", for network" << network);
+        this->finishPhase("collectResult", collectResultProbe);
+
+        if (control != nullptr) {
+            control->onFinished();
+        }
+        bool cancelled = not converged and control != nullptr and control->isCancelled();
+        return PageRankResult { std::move(result), numIterations, difference, converged, cancelled };
     }
 
     std::string getName() const
     {
         return "SingleThreadedPageRankComputer";
     }
+
+private:
+    static std::vector<PageIdAndRank> collectRanks(std::unordered_map<PageId, PageRank, PageIdHash> const& pageHashMap)
+    {
+        std::vector<PageIdAndRank> ranks;
+        ranks.reserve(pageHashMap.size());
+        for (auto const& iter : pageHashMap) {
+            ranks.push_back(PageIdAndRank(iter.first, iter.second));
+        }
+        return ranks;
+    }
+
+    // The only thread is busy for the whole phase
+    void reportPhase(std::string const& phase, WorkMeasurement const& measurement) const
+    {
+        this->observer->onPhaseFinished(phase, measurement.busySeconds);
+        this->observer->onThreadFinished(phase, 0, measurement.busySeconds, 0);
+        if (measurement.counters.numSamples > 0) {
+            this->observer->onThreadCounters(phase, 0, measurement.counters);
+        }
+    }
+
+    void finishPhase(std::string const& phase, WorkProbe& probe) const
+    {
+        if (this->observer != nullptr) {
+            WorkMeasurement measurement;
+            probe.finish(measurement);
+            this->reportPhase(phase, measurement);
+        }
+    }
 };
 
 #endif /* SRC_SINGLETHREADEDPAGERANKCOMPUTER_HPP_ */
@@ -0,0 +1,100 @@
+#ifndef SRC_WORKERPOOL_HPP_
+#define SRC_WORKERPOOL_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hardwareCounters.hpp"
+
+// Threads kept for the whole computation, for work repeated many times like the
+// sweeps of iterations. run() gives every worker the same function and waits for
+// all of them. Every worker opens its hardware counters once, when counted, and
+// WorkProbes of its pieces of work read them, so iterations cost no more syscalls
+// than reading the counters.
+class WorkerPool {
+public:
+    typedef std::function<void(uint32_t thread, HardwareCounters& counters)> Function;
+
+    WorkerPool(uint32_t numThreadsArg, bool countedArg)
+        : numThreads(numThreadsArg)
+        , counted(countedArg)
+        , function(nullptr)
+        , generation(0)
+        , numRunning(0)
+        , stopping(false)
+    {
+        for (uint32_t t = 0; t < this->numThreads; ++t) {
+            this->workers.push_back(std::thread { [this, t] { this->work(t); } });
+        }
+    }
+
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->workAvailable.notify_all();
+        for (auto& worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    // Calls function(t, counters of worker t) on every worker t, returns when all of them did
+    void run(Function const& functionArg)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->function = &functionArg;
+        this->numRunning = this->numThreads;
+        ++this->generation;
+        this->workAvailable.notify_all();
+        this->workDone.wait(lock, [this] { return this->numRunning == 0; });
+        this->function = nullptr;
+    }
+
+private:
+    void work(uint32_t t)
+    {
+        HardwareCounters counters(this->counted);
+        uint64_t doneGeneration = 0;
+        while (true) {
+            Function const* nextFunction;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->workAvailable.wait(lock, [&] { return this->stopping or this->generation != doneGeneration; });
+                if (this->stopping) {
+                    return;
+                }
+                doneGeneration = this->generation;
+                nextFunction = this->function;
+            }
+
+            (*nextFunction)(t, counters);
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (--this->numRunning == 0) {
+                this->workDone.notify_one();
+            }
+        }
+    }
+
+    uint32_t numThreads;
+    bool counted;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    Function const* function;
+    uint64_t generation;
+    uint32_t numRunning;
+    bool stopping;
+};
+
+#endif /* SRC_WORKERPOOL_HPP_ */
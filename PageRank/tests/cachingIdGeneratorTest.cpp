@@ -0,0 +1,230 @@
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../src/immutable/common.hpp"
+
+#include "../src/cachingIdGenerator.hpp"
+#include "../src/sha256IdGenerator.hpp"
+
+class CountingIdGenerator : public IdGenerator {
+public:
+    CountingIdGenerator()
+        : numCalls(0)
+    {
+    }
+
+    virtual PageId generateId(std::string const& content) const
+    {
+        ++this->numCalls;
+        return PageId("id_" + content);
+    }
+
+    mutable std::atomic<uint32_t> numCalls;
+};
+
+void testXxHash64(std::string const& testScenario, uint64_t expectedResult)
+{
+    uint64_t result = XxHash64::hash(testScenario.data(), testScenario.size());
+    ASSERT(result == expectedResult,
+        "Incorrect XXH64, scenario=" << testScenario << ", result=" << std::hex << result
+                                     << ", expectedResult=" << expectedResult);
+}
+
+void testCacheHitsAndPersistence()
+{
+    std::string cacheFilename = "temp_id_cache_test";
+    std::remove(cacheFilename.data());
+
+    CountingIdGenerator countingGenerator;
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        ASSERT(generator.generateId("Ala ma kota") == PageId("id_Ala ma kota"), "Incorrect id from empty cache");
+        ASSERT(generator.generateId("Ala ma kota") == PageId("id_Ala ma kota"), "Incorrect id from cache");
+        ASSERT(generator.generateId("Ala ma psa") == PageId("id_Ala ma psa"), "Incorrect id of second content");
+        ASSERT(countingGenerator.numCalls == 2, "Cache did not skip the generator, calls=" << countingGenerator.numCalls);
+        ASSERT(generator.getStats().numHits == 1 and generator.getStats().numMisses == 2,
+            "Unexpected stats: " << generator.getStats());
+        ASSERT(generator.save(), "Could not save the cache");
+    }
+
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        ASSERT(generator.getStats().numEntries == 2, "Cache not loaded from file: " << generator.getStats());
+        ASSERT(generator.generateId("Ala ma kota") == PageId("id_Ala ma kota"), "Incorrect id from loaded cache");
+        ASSERT(generator.generateId("Ala ma psa") == PageId("id_Ala ma psa"), "Incorrect id from loaded cache");
+        ASSERT(countingGenerator.numCalls == 2, "Loaded cache did not skip the generator, calls=" << countingGenerator.numCalls);
+        ASSERT(generator.getStats().getHitRate() == 1.0, "Unexpected stats: " << generator.getStats());
+    }
+
+    std::remove(cacheFilename.data());
+}
+
+// Entries not looked up since the cache was loaded are not saved again
+void testUnusedEntriesDropped()
+{
+    std::string cacheFilename = "temp_id_cache_unused_test";
+    std::remove(cacheFilename.data());
+
+    CountingIdGenerator countingGenerator;
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        generator.generateId("Ala ma kota");
+        generator.generateId("Ala ma psa");
+        ASSERT(generator.save(), "Could not save the cache");
+    }
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        generator.generateId("Ala ma kota");
+        generator.generateId("Ala ma chomika");
+        ASSERT(generator.save(), "Could not save the cache");
+    }
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        ASSERT(generator.getStats().numEntries == 2, "Unused entry saved: " << generator.getStats());
+        generator.generateId("Ala ma kota");
+        generator.generateId("Ala ma chomika");
+        ASSERT(countingGenerator.numCalls == 3, "Used entries not saved, calls=" << countingGenerator.numCalls);
+    }
+
+    std::remove(cacheFilename.data());
+}
+
+// A cache file written for another generator must not serve its ids
+void testOtherGeneratorIgnored()
+{
+    std::string cacheFilename = "temp_id_cache_other_generator_test";
+    std::remove(cacheFilename.data());
+
+    CountingIdGenerator countingGenerator;
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        generator.generateId("Ala ma kota");
+        ASSERT(generator.save(), "Could not save the cache");
+    }
+    {
+        CachingIdGenerator generator(countingGenerator, "other", cacheFilename);
+        ASSERT(generator.getStats().numEntries == 0, "Cache of another generator loaded: " << generator.getStats());
+    }
+
+    std::remove(cacheFilename.data());
+}
+
+void testCorruptedCacheFile(std::string const& testScenario, std::string const& cacheContent)
+{
+    std::string cacheFilename = "temp_id_cache_corrupted_test";
+    {
+        std::ofstream out(cacheFilename, std::ios::trunc);
+        out << cacheContent;
+    }
+
+    CountingIdGenerator countingGenerator;
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        ASSERT(generator.getStats().numEntries == 0, "Corrupted cache loaded, scenario=" << testScenario << ": " << generator.getStats());
+        ASSERT(generator.generateId("Ala ma kota") == PageId("id_Ala ma kota"), "Incorrect id, scenario=" << testScenario);
+        ASSERT(generator.generateId("Ala ma psa") == PageId("id_Ala ma psa"), "Incorrect id, scenario=" << testScenario);
+        ASSERT(countingGenerator.numCalls == 2, "Corrupted cache used, scenario=" << testScenario);
+        ASSERT(generator.save(), "Could not overwrite corrupted cache, scenario=" << testScenario);
+    }
+
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        ASSERT(generator.getStats().numEntries == 2, "Overwritten cache not loaded, scenario=" << testScenario << ": " << generator.getStats());
+        ASSERT(generator.generateId("Ala ma kota") == PageId("id_Ala ma kota"), "Incorrect id, scenario=" << testScenario);
+        ASSERT(countingGenerator.numCalls == 2, "Overwritten cache not used, scenario=" << testScenario);
+    }
+
+    std::remove(cacheFilename.data());
+}
+
+void testCorruptedCacheFiles()
+{
+    std::string cacheFilename = "temp_id_cache_corrupted_test";
+    std::remove(cacheFilename.data());
+
+    CountingIdGenerator countingGenerator;
+    {
+        CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+        generator.generateId("Ala ma kota");
+        generator.generateId("Ala ma psa");
+        ASSERT(generator.save(), "Could not save the cache");
+    }
+    std::stringstream content;
+    content << std::ifstream(cacheFilename).rdbuf();
+    std::string validContent = content.str();
+
+    // Cut within the id of the last entry, which would otherwise load as a wrong id
+    testCorruptedCacheFile("truncated", validContent.substr(0, validContent.size() - 3));
+    testCorruptedCacheFile("garbage", "not a cache\n" + validContent);
+    testCorruptedCacheFile("missing id", validContent + "123 11 \n");
+}
+
+void testConcurrentLookups()
+{
+    std::string cacheFilename = "temp_id_cache_concurrent_test";
+    std::remove(cacheFilename.data());
+
+    CountingIdGenerator countingGenerator;
+    CachingIdGenerator generator(countingGenerator, "counting", cacheFilename);
+
+    uint32_t const numThreads = 8;
+    uint32_t const numContents = 1000;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t) {
+        threads.push_back(std::thread { [&generator] {
+            for (uint32_t i = 0; i < numContents; ++i) {
+                std::string content = std::to_string(i);
+                ASSERT(generator.generateId(content) == PageId("id_" + content), "Incorrect id of " << content);
+            }
+        } });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    IdCacheStats stats = generator.getStats();
+    ASSERT(stats.numEntries == numContents, "Unexpected stats: " << stats);
+    ASSERT(stats.numHits + stats.numMisses == numThreads * numContents, "Unexpected stats: " << stats);
+    ASSERT(stats.numMisses == countingGenerator.numCalls, "Unexpected stats: " << stats);
+}
+
+void testCachedSha256()
+{
+    std::string cacheFilename = "temp_id_cache_sha256_test";
+    std::remove(cacheFilename.data());
+
+    Sha256IdGenerator sha256Generator;
+    CachingIdGenerator generator(sha256Generator, "sha256", cacheFilename);
+    for (uint32_t i = 0; i < 2; ++i) {
+        ASSERT(generator.generateId("Ala ma kota\n") == PageId("c51bc001db0206126e1681ba88497ce583f077a92e427e4f62da96b691d28813"),
+            "Incorrect cached SHA256");
+    }
+    ASSERT(generator.getStats().numHits == 1, "Unexpected stats: " << generator.getStats());
+}
+
+int main()
+{
+    testXxHash64("", 0xEF46DB3751D8E999ULL);
+    testXxHash64("a", 0xD24EC4F1A98C6E5BULL);
+    testXxHash64("abc", 0x44BC2CF5AD770999ULL);
+    testXxHash64("1234", 0xD8316E61D84F6BA4ULL);
+    testXxHash64("12345678", 0xD2D02F08CF7CFD4AULL);
+    // 32-byte stripes, followed by tails of 0, 8 + 3, 4 + 3 and 8 + 4 bytes
+    testXxHash64("0123456789abcdef0123456789abcdef", 0x642A94958E71E6C5ULL);
+    testXxHash64("The quick brown fox jumps over the lazy dog", 0x0B242D361FDA71BCULL);
+    testXxHash64("Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL);
+    testXxHash64("0123456789abcdef0123456789abcdef0123456789ab", 0x1187118B194FD24AULL);
+
+    testCacheHitsAndPersistence();
+    testUnusedEntriesDropped();
+    testOtherGeneratorIgnored();
+    testCorruptedCacheFiles();
+    testConcurrentLookups();
+    testCachedSha256();
+
+    return 0;
+}
@@ -1,14 +1,20 @@
 #include <algorithm>
+#include <cstdlib>
+#include <iterator>
 #include <memory>
 
 #include "lib/networkGenerator.hpp"
 #include "lib/performanceTimer.hpp"
+#include "lib/pipelinedNetworkLoader.hpp"
 #include "lib/resultVerificator.hpp"
+#include "lib/statsDump.hpp"
 
 #include "../src/immutable/common.hpp"
 #include "../src/immutable/pageRankComputer.hpp"
 
+#include "../src/cachingIdGenerator.hpp"
 #include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/pageRankObservable.hpp"
 #include "../src/sha256IdGenerator.hpp"
 #include "../src/singleThreadedPageRankComputer.hpp"
 
@@ -31,23 +37,107 @@ void pageRankComputationWithNetwork(PageRankComputer const& computer, Network co
     ASSERT(found, "Test result not found");
 }
 
+// Measures from its construction to the start of the first iteration of a computation
+class FirstIterationTimer : public PageRankObserver {
+public:
+    FirstIterationTimer()
+        : seconds(-1)
+    {
+    }
+
+    void onIterationFinished(uint32_t, double iterationSeconds, double, uint64_t)
+    {
+        if (this->seconds < 0) {
+            this->seconds = this->timer.getSeconds() - iterationSeconds;
+        }
+    }
+
+    double getSeconds() const
+    {
+        return this->seconds;
+    }
+
+private:
+    PerformanceTimer timer;
+    double seconds;
+};
+
+// Time to first iteration when the scenario is loaded sequentially, leaving the ids to the computer,
+// and when it is loaded by the pipeline, which generates the ids while parsing
+void timeToFirstIteration(PageRankComputer& computer, std::string const& scenario, IdGenerator const& idGenerator,
+    uint32_t numLoaderThreads)
+{
+    double sequentialSeconds, pipelinedSeconds;
+    {
+        std::istringstream in(scenario);
+        FirstIterationTimer firstIteration;
+        PageRankObservable::setObserverOf(computer, &firstIteration);
+        Network network = StdinGenerator(idGenerator, in).generateNetworkOfSize(1200);
+        computer.computeForNetwork(network, 0.85, 100, 0.0000001);
+        sequentialSeconds = firstIteration.getSeconds();
+    }
+    {
+        std::istringstream in(scenario);
+        FirstIterationTimer firstIteration;
+        PageRankObservable::setObserverOf(computer, &firstIteration);
+        Network network = PipelinedNetworkLoader(idGenerator, numLoaderThreads).loadNetworkOfSize(in, 1200);
+        computer.computeForNetwork(network, 0.85, 100, 0.0000001);
+        pipelinedSeconds = firstIteration.getSeconds();
+    }
+    PageRankObservable::setObserverOf(computer, nullptr);
+
+    std::cout << "Time to first iteration [" << computer.getName() << ", " << numLoaderThreads
+              << " loader threads]: sequential " << sequentialSeconds << "s, pipelined " << pipelinedSeconds << "s"
+              << std::endl;
+}
+
 int main(int argc, char** argv)
 {
-    ASSERT(argc <= 2, "Too many arguments: " << argc);
+    // Usage: e2eTest [numThreads [idCacheFile]] < scenario
+    // Setting PAGERANK_E2E_TIMING compares time to first iteration of a sequential and a pipelined
+    // load as well; each of them generates all ids again.
+    ASSERT(argc <= 3, "Too many arguments: " << argc);
 
     // Prepare computer
     std::shared_ptr<PageRankComputer> computerPtr;
+    uint32_t numLoaderThreads = std::max(1u, std::thread::hardware_concurrency());
     if (argc == 1) {
         computerPtr = std::shared_ptr<PageRankComputer>(new SingleThreadedPageRankComputer {});
     } else {
         uint32_t numThreads;
         std::stringstream(argv[1]) >> numThreads;
         computerPtr = std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { numThreads });
+        numLoaderThreads = numThreads;
+    }
+
+    Sha256IdGenerator sha256IdGenerator;
+    std::string scenario(std::istreambuf_iterator<char>(std::cin), {});
+    if (std::getenv("PAGERANK_E2E_TIMING") != nullptr) {
+        // Without the id cache, so neither load finds the ids of the other one cached
+        timeToFirstIteration(*computerPtr, scenario, sha256IdGenerator, numLoaderThreads);
     }
 
-    Sha256IdGenerator idGenerator;
-    StdinGenerator networkGenerator(idGenerator);
-    pageRankComputationWithNetwork(*computerPtr, networkGenerator.generateNetworkOfSize(1200));
+    std::shared_ptr<CachingIdGenerator> cachingIdGenerator;
+    if (argc == 3) {
+        cachingIdGenerator = std::make_shared<CachingIdGenerator>(sha256IdGenerator, "sha256", argv[2]);
+    }
+    IdGenerator const& idGenerator = cachingIdGenerator ? *cachingIdGenerator : static_cast<IdGenerator const&>(sha256IdGenerator);
+
+    std::istringstream in(scenario);
+    PipelinedNetworkLoader networkLoader(idGenerator, numLoaderThreads);
+    Network network = networkLoader.loadNetworkOfSize(in, 1200);
+    std::cout << networkLoader.getStats() << std::endl;
+    if (cachingIdGenerator) {
+        std::cout << "Id cache: " << cachingIdGenerator->getStats() << std::endl;
+        ASSERT(cachingIdGenerator->save(), "Could not save id cache to " << argv[2]);
+    }
+
+    PageRankStats stats(StatsDump::wantsHardwareCounters());
+    if (StatsDump::isRequested()) {
+        PageRankObservable::setObserverOf(*computerPtr, &stats);
+    }
+    pageRankComputationWithNetwork(*computerPtr, network);
+    StatsDump::append(stats);
 
     return 0;
 }
@@ -0,0 +1,76 @@
+#ifndef TESTS_LIB_ALLOCATIONCOUNTER_HPP_
+#define TESTS_LIB_ALLOCATIONCOUNTER_HPP_
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+// Replaces the global operator new of the test binary including this header
+// (at most one translation unit), so tests can count heap allocations.
+// Heap usage is read from glibc, so it is 0 with other C libraries.
+class AllocationCounter {
+public:
+    static size_t getNumAllocations()
+    {
+        return numAllocations.load(std::memory_order_relaxed);
+    }
+
+    // Bytes currently allocated from the heap by the whole process. Unlike the resident
+    // set size it drops as soon as memory is freed, even if the allocator keeps it.
+    static size_t getHeapBytes()
+    {
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 33)
+        struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+#else
+        return 0;
+#endif
+    }
+
+    static void* allocate(size_t size)
+    {
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+        void* pointer = std::malloc(size == 0 ? 1 : size);
+        if (pointer == nullptr) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+
+private:
+    static inline std::atomic<size_t> numAllocations { 0 };
+};
+
+void* operator new(size_t size)
+{
+    return AllocationCounter::allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return AllocationCounter::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif /* TESTS_LIB_ALLOCATIONCOUNTER_HPP_ */
@@ -0,0 +1,39 @@
+#ifndef TESTS_LIB_ARENANETWORKLOADER_HPP_
+#define TESTS_LIB_ARENANETWORKLOADER_HPP_
+
+#include <istream>
+#include <string>
+
+#include "../../src/arenaNetwork.hpp"
+#include "../../src/immutable/common.hpp"
+
+// Reads the scenario format of StdinGenerator (number of pages, then a line with the
+// content and a line with space separated links of every page) straight into an arena.
+// Lines are read into a single reused buffer, so pages cost no allocations of their own.
+class ArenaNetworkLoader {
+public:
+    static ArenaNetwork loadNetworkOfSize(std::istream& in, uint32_t size, IdGenerator const& idGenerator)
+    {
+        std::string line;
+        std::getline(in, line);
+        uint32_t numberOfNodes = std::stoul(line);
+        ASSERT(numberOfNodes == size, "Incorrect size=" << size << ", fromStdin=" << numberOfNodes);
+
+        ArenaNetworkBuilder builder(idGenerator);
+        for (uint32_t i = 0; i < numberOfNodes; ++i) {
+            std::getline(in, line);
+            builder.startPage(line);
+
+            std::getline(in, line);
+            size_t position = line.find_first_not_of(' ');
+            while (position != std::string::npos) {
+                size_t end = line.find(' ', position);
+                builder.addLink(std::string_view(line).substr(position, end - position));
+                position = line.find_first_not_of(' ', end);
+            }
+        }
+        return builder.build();
+    }
+};
+
+#endif /* TESTS_LIB_ARENANETWORKLOADER_HPP_ */
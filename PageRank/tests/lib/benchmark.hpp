@@ -0,0 +1,309 @@
+#ifndef TESTS_LIB_BENCHMARK_HPP_
+#define TESTS_LIB_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "../../src/immutable/common.hpp"
+#include "../../src/immutable/pageRankComputer.hpp"
+#include "../../src/pageRankObservable.hpp"
+#include "../../src/pageRankStats.hpp"
+
+#include "networkGenerator.hpp"
+#include "performanceTimer.hpp"
+
+// Same as ASSERT(false, message), but the compiler knows control never
+// returns from it, also in unoptimized builds
+#define FAIL(message)                            \
+    do {                                         \
+        std::ostringstream str;                  \
+        str << message;                          \
+        std::cerr << str.str() << std::endl;     \
+        std::abort();                            \
+    } while (0)
+
+struct BenchmarkResult {
+    std::string family;
+    uint32_t numNodes;
+    size_t numEdges;
+    std::string computer;
+    uint32_t numThreads;
+    uint32_t numTrials;
+    double minSeconds;
+    double medianSeconds;
+    double p90Seconds;
+    double maxSeconds;
+    uint32_t numIterations;
+    // In-edges visited per second of the iterations of the instrumented run
+    double edgesPerSecond;
+    // Of the rank sweeps of the instrumented run; -1 when hardware counters were not collected or not available
+    double instructionsPerCycle;
+    double llcMissesPerEdge;
+
+    // Results of two runs are matched by this key in compare mode
+    std::string getKey() const
+    {
+        return this->family + "/" + std::to_string(this->numNodes) + "/" + this->computer;
+    }
+};
+
+class BenchmarkStatistics {
+public:
+    // Nearest-rank percentile, p in [0, 1]
+    static double percentile(std::vector<double> samples, double p)
+    {
+        ASSERT(not samples.empty(), "Percentile of no samples");
+        std::sort(samples.begin(), samples.end());
+        size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[rank == 0 ? 0 : rank - 1];
+    }
+
+    static double median(std::vector<double> const& samples)
+    {
+        return percentile(samples, 0.5);
+    }
+};
+
+// Runs every computer on every (family, size) pair: the network is generated
+// anew before each trial (outside of the measured time), because computers
+// generate page ids and the first trial would otherwise pay for all of them.
+// Trials run without an observer, so their times do not include instrumentation;
+// iterations, edges per second and counters come from one extra instrumented run.
+class BenchmarkRunner {
+public:
+    BenchmarkRunner(uint32_t numWarmupRunsArg, uint32_t numTrialsArg, bool hardwareCountersArg = false)
+        : numWarmupRuns(numWarmupRunsArg)
+        , numTrials(numTrialsArg)
+        , hardwareCounters(hardwareCountersArg)
+    {
+        ASSERT(this->numTrials > 0, "Benchmark needs at least one trial");
+    }
+
+    BenchmarkResult run(std::string const& family, NetworkGenerator const& networkGenerator, uint32_t numNodes,
+        PageRankComputer& computer, uint32_t numThreads) const
+    {
+        PageRankObservable::setObserverOf(computer, nullptr);
+        size_t numEdges = 0;
+        std::vector<double> samples;
+        for (uint32_t i = 0; i < this->numWarmupRuns + this->numTrials; ++i) {
+            Network network = networkGenerator.generateNetworkOfSize(numNodes);
+            numEdges = 0;
+            for (auto const& page : network.getPages()) {
+                numEdges += page.getLinks().size();
+            }
+
+            PerformanceTimer timer;
+            std::vector<PageIdAndRank> result = computer.computeForNetwork(network, 0.85, 100, 0.0000001);
+            double seconds = timer.getSeconds();
+            ASSERT(result.size() == network.getSize(), "Invalid result size=" << result.size());
+
+            if (i >= this->numWarmupRuns) {
+                samples.push_back(seconds);
+            }
+        }
+
+        PageRankStats stats = this->collectStats(networkGenerator, numNodes, computer);
+        double iterationSeconds = 0;
+        for (auto const& iteration : stats.getIterations()) {
+            iterationSeconds += iteration.seconds;
+        }
+
+        return BenchmarkResult { family, numNodes, numEdges, computer.getName(), numThreads, this->numTrials,
+            BenchmarkStatistics::percentile(samples, 0.0), BenchmarkStatistics::median(samples),
+            BenchmarkStatistics::percentile(samples, 0.9), BenchmarkStatistics::percentile(samples, 1.0),
+            static_cast<uint32_t>(stats.getIterations().size()),
+            iterationSeconds > 0 ? stats.getEdgesProcessed() / iterationSeconds : 0,
+            PageRankStats::getInstructionsPerCycle(stats.getPhaseCounters("rankSweep")), stats.getLlcMissesPerEdge() };
+    }
+
+private:
+    // One more computation with the observer attached, its time is not part of the samples
+    PageRankStats collectStats(NetworkGenerator const& networkGenerator, uint32_t numNodes, PageRankComputer& computer) const
+    {
+        PageRankStats stats(this->hardwareCounters);
+        Network network = networkGenerator.generateNetworkOfSize(numNodes);
+        PageRankObservable::setObserverOf(computer, &stats);
+        computer.computeForNetwork(network, 0.85, 100, 0.0000001);
+        PageRankObservable::setObserverOf(computer, nullptr);
+        return stats;
+    }
+
+    uint32_t numWarmupRuns;
+    uint32_t numTrials;
+    bool hardwareCounters;
+};
+
+// Results are written either as CSV (with a header line) or as a JSON array
+// with one flat object per line, both formats can be read back for comparison.
+class BenchmarkResultFile {
+public:
+    static void writeCsv(std::ostream& out, std::vector<BenchmarkResult> const& results)
+    {
+        out << std::setprecision(9);
+        out << "family,numNodes,numEdges,computer,numThreads,numTrials,minSeconds,medianSeconds,p90Seconds,maxSeconds,numIterations,edgesPerSecond,instructionsPerCycle,llcMissesPerEdge\n";
+        for (auto const& result : results) {
+            out << result.family << "," << result.numNodes << "," << result.numEdges << ","
+                << "\"" << result.computer << "\"," << result.numThreads << "," << result.numTrials << ","
+                << result.minSeconds << "," << result.medianSeconds << "," << result.p90Seconds << ","
+                << result.maxSeconds << "," << result.numIterations << "," << result.edgesPerSecond << ","
+                << result.instructionsPerCycle << "," << result.llcMissesPerEdge << "\n";
+        }
+    }
+
+    static void writeJson(std::ostream& out, std::vector<BenchmarkResult> const& results)
+    {
+        out << std::setprecision(9);
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            auto const& result = results[i];
+            out << "{\"family\": \"" << result.family << "\", \"numNodes\": " << result.numNodes
+                << ", \"numEdges\": " << result.numEdges << ", \"computer\": \"" << result.computer
+                << "\", \"numThreads\": " << result.numThreads << ", \"numTrials\": " << result.numTrials
+                << ", \"minSeconds\": " << result.minSeconds << ", \"medianSeconds\": " << result.medianSeconds
+                << ", \"p90Seconds\": " << result.p90Seconds << ", \"maxSeconds\": " << result.maxSeconds
+                << ", \"numIterations\": " << result.numIterations << ", \"edgesPerSecond\": " << result.edgesPerSecond
+                << ", \"instructionsPerCycle\": " << result.instructionsPerCycle
+                << ", \"llcMissesPerEdge\": " << result.llcMissesPerEdge << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+
+    static std::vector<BenchmarkResult> read(std::string const& filename)
+    {
+        std::ifstream in(filename);
+        ASSERT(in.is_open(), "Cannot open benchmark results " << filename);
+
+        std::vector<BenchmarkResult> results;
+        std::vector<std::string> csvColumns;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::map<std::string, std::string> fields;
+            if (line.find('{') != std::string::npos) {
+                fields = parseJsonLine(line);
+            } else if (line.compare(0, 7, "family,") == 0) {
+                csvColumns = splitCsvLine(line);
+                continue;
+            } else if (line.empty() or line[0] == '[' or line[0] == ']') {
+                continue;
+            } else {
+                std::vector<std::string> values = splitCsvLine(line);
+                ASSERT(values.size() == csvColumns.size(), "Unexpected number of columns in: " << line);
+                for (size_t i = 0; i < values.size(); ++i) {
+                    fields[csvColumns[i]] = values[i];
+                }
+            }
+
+            results.push_back(BenchmarkResult { fields["family"], toNumber<uint32_t>(fields["numNodes"]),
+                toNumber<size_t>(fields["numEdges"]), fields["computer"], toNumber<uint32_t>(fields["numThreads"]),
+                toNumber<uint32_t>(fields["numTrials"]), toNumber<double>(fields["minSeconds"]),
+                toNumber<double>(fields["medianSeconds"]), toNumber<double>(fields["p90Seconds"]),
+                toNumber<double>(fields["maxSeconds"]), toNumber<uint32_t>(fields["numIterations"]),
+                toNumber<double>(fields["edgesPerSecond"]), toNumber<double>(fields["instructionsPerCycle"], -1),
+                toNumber<double>(fields["llcMissesPerEdge"], -1) });
+        }
+        return results;
+    }
+
+private:
+    template <typename T>
+    static T toNumber(std::string const& str, T defaultValue = T())
+    {
+        T value = defaultValue;
+        std::stringstream(str) >> value;
+        return value;
+    }
+
+    static std::vector<std::string> splitCsvLine(std::string const& line)
+    {
+        std::vector<std::string> values(1);
+        bool quoted = false;
+        for (char c : line) {
+            if (c == '"') {
+                quoted = not quoted;
+            } else if (c == ',' and not quoted) {
+                values.emplace_back();
+            } else {
+                values.back() += c;
+            }
+        }
+        return values;
+    }
+
+    // Understands only the flat objects written by writeJson
+    static std::map<std::string, std::string> parseJsonLine(std::string const& line)
+    {
+        std::map<std::string, std::string> fields;
+        size_t position = line.find('{') + 1;
+        while (true) {
+            size_t keyStart = line.find('"', position);
+            if (keyStart == std::string::npos) {
+                break;
+            }
+            size_t keyEnd = line.find('"', keyStart + 1);
+            size_t valueStart = line.find_first_not_of(" :", keyEnd + 1);
+
+            size_t valueEnd;
+            std::string value;
+            if (line[valueStart] == '"') {
+                valueEnd = line.find('"', valueStart + 1);
+                value = line.substr(valueStart + 1, valueEnd - valueStart - 1);
+                ++valueEnd;
+            } else {
+                valueEnd = line.find_first_of(",}", valueStart);
+                value = line.substr(valueStart, valueEnd - valueStart);
+            }
+
+            fields[line.substr(keyStart + 1, keyEnd - keyStart - 1)] = value;
+            position = valueEnd;
+        }
+        return fields;
+    }
+};
+
+class BenchmarkComparator {
+public:
+    // Prints median time of every benchmark present in both files and flags the ones
+    // that got slower by more than threshold (relative), returns number of regressions
+    static uint32_t compare(std::vector<BenchmarkResult> const& baseline, std::vector<BenchmarkResult> const& current,
+        double threshold, std::ostream& out)
+    {
+        std::map<std::string, BenchmarkResult> baselineByKey;
+        for (auto const& result : baseline) {
+            baselineByKey.emplace(result.getKey(), result);
+        }
+
+        uint32_t numRegressions = 0;
+        for (auto const& result : current) {
+            auto iter = baselineByKey.find(result.getKey());
+            if (iter == baselineByKey.end()) {
+                out << "NEW        " << result.getKey() << ": " << result.medianSeconds << "s" << std::endl;
+                continue;
+            }
+
+            double change = result.medianSeconds / iter->second.medianSeconds - 1.0;
+            bool isRegression = change > threshold;
+            numRegressions += isRegression;
+
+            out << (isRegression ? "REGRESSION " : (change < -threshold ? "IMPROVED   " : "OK         "))
+                << result.getKey() << ": " << iter->second.medianSeconds << "s -> " << result.medianSeconds
+                << "s (" << (change >= 0 ? "+" : "") << 100.0 * change << "%)" << std::endl;
+            baselineByKey.erase(iter);
+        }
+
+        for (auto const& missing : baselineByKey) {
+            out << "MISSING    " << missing.first << std::endl;
+        }
+        return numRegressions;
+    }
+};
+
+#endif /* TESTS_LIB_BENCHMARK_HPP_ */
@@ -0,0 +1,104 @@
+#ifndef TESTS_LIB_BOUNDEDQUEUE_HPP_
+#define TESTS_LIB_BOUNDEDQUEUE_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+struct BoundedQueueStats {
+    size_t capacity;
+    size_t numPushes;
+    size_t maxDepth;
+    double averageDepth;
+    // How many times a producer had to wait because the queue was full
+    size_t numFullWaits;
+    // How many times a consumer had to wait because the queue was empty
+    size_t numEmptyWaits;
+};
+
+// Blocking FIFO with limited capacity, used to connect stages of a pipeline.
+// Producers block while the queue is full, consumers block while it is empty.
+// After close() consumers drain the remaining items and then pop() returns false.
+template <typename T>
+class BoundedQueue {
+public:
+    BoundedQueue(size_t capacityArg)
+        : capacity(capacityArg)
+        , closed(false)
+        , numPushes(0)
+        , depthSum(0)
+        , maxDepth(0)
+        , numFullWaits(0)
+        , numEmptyWaits(0)
+    {
+    }
+
+    void push(T&& item)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->items.size() >= this->capacity) {
+            ++this->numFullWaits;
+            this->notFull.wait(lock, [this] { return this->items.size() < this->capacity; });
+        }
+
+        this->items.push_back(std::move(item));
+
+        ++this->numPushes;
+        this->depthSum += this->items.size();
+        this->maxDepth = std::max(this->maxDepth, this->items.size());
+
+        this->notEmpty.notify_one();
+    }
+
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->items.empty() and not this->closed) {
+            ++this->numEmptyWaits;
+            this->notEmpty.wait(lock, [this] { return not this->items.empty() or this->closed; });
+        }
+
+        if (this->items.empty()) {
+            return false;
+        }
+
+        item = std::move(this->items.front());
+        this->items.pop_front();
+
+        this->notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closed = true;
+        this->notEmpty.notify_all();
+    }
+
+    BoundedQueueStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return BoundedQueueStats { this->capacity, this->numPushes, this->maxDepth,
+            this->numPushes == 0 ? 0.0 : static_cast<double>(this->depthSum) / this->numPushes,
+            this->numFullWaits, this->numEmptyWaits };
+    }
+
+private:
+    size_t capacity;
+    std::deque<T> items;
+    bool closed;
+
+    size_t numPushes;
+    size_t depthSum;
+    size_t maxDepth;
+    size_t numFullWaits;
+    size_t numEmptyWaits;
+
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+#endif /* TESTS_LIB_BOUNDEDQUEUE_HPP_ */
@@ -1,7 +1,16 @@
 #ifndef NETWORK_GENERATOR
 #define NETWORK_GENERATOR
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../../src/compiledNetwork.hpp"
 #include "../../src/immutable/network.hpp"
+#include "../../src/preparedNetwork.hpp"
 
 class NetworkGenerator {
 public:
@@ -39,6 +48,7 @@ public:
     virtual Network generateNetworkOfSize(uint32_t const size) const
     {
         Network network(this->idGenerator);
+        network.reserve(size);
         for (uint32_t i = 0; i < size; ++i) {
             Page page = this->generatePageFromNum(i);
 
@@ -52,7 +62,7 @@ public:
                 }
             }
 
-            network.addPage(page);
+            network.addPage(std::move(page));
         }
 
         return network;
@@ -69,6 +79,7 @@ public:
     Network generateNetworkOfSize(uint32_t const size) const
     {
         Network network(this->idGenerator);
+        network.reserve(size);
         uint32_t connectedPartSize = size / 1000;
 
         for (uint32_t i = 0; i < connectedPartSize; ++i) {
@@ -82,7 +93,7 @@ public:
                     page.addLink(this->generatePageFromNumWithGeneratedId(j).getId());
                 }
             }
-            network.addPage(page);
+            network.addPage(std::move(page));
         }
 
         for (uint32_t i = connectedPartSize; i < size; ++i) {
@@ -91,17 +102,421 @@ public:
             if (i % 1000 == 333) {
                 page.addLink(this->generatePageFromNumWithGeneratedId(i - 127).getId());
             }
-            network.addPage(page);
+            network.addPage(std::move(page));
         }
 
         return network;
     }
 };
 
+// Crawl-like network of hosts of hostSize pages with consecutive numbers, so the host of a page
+// is its number divided by hostSize. Every page links to about linksPerPage pages, all but
+// about one in ten of them on its own host, and every tenth page has no links at all.
+class HostNetworkGenerator : public NetworkGenerator {
+public:
+    HostNetworkGenerator(IdGenerator const& idGeneratorArg, uint32_t hostSizeArg = 100, uint32_t linksPerPageArg = 8)
+        : NetworkGenerator(idGeneratorArg)
+        , hostSize(hostSizeArg)
+        , linksPerPage(linksPerPageArg)
+    {
+    }
+
+    Network generateNetworkOfSize(uint32_t const size) const
+    {
+        Network network(this->idGenerator);
+        network.reserve(size);
+        uint64_t state = 0x9e3779b97f4a7c15;
+        auto next = [&](uint32_t bound) {
+            state = state * 6364136223846793005 + 1442695040888963407;
+            return static_cast<uint32_t>((state >> 33) % bound);
+        };
+
+        for (uint32_t i = 0; i < size; ++i) {
+            Page page = this->generatePageFromNum(i);
+            if (i % 10 != 9) {
+                uint32_t hostBegin = i - i % this->hostSize;
+                uint32_t hostEnd = std::min(size, hostBegin + this->hostSize);
+                for (uint32_t link = 0; link < this->linksPerPage; ++link) {
+                    uint32_t j = next(10) == 0 ? next(size) : hostBegin + next(hostEnd - hostBegin);
+                    if (j != i) {
+                        page.addLink(this->generatePageFromNumWithGeneratedId(j).getId());
+                    }
+                }
+            }
+            network.addPage(std::move(page));
+        }
+        return network;
+    }
+
+private:
+    uint32_t hostSize;
+    uint32_t linksPerPage;
+};
+
+// Out-adjacency of a generated graph in compressed sparse row form:
+// links of vertex v are targets[offsets[v]] ... targets[offsets[v + 1] - 1]
+struct CsrGraph {
+    uint32_t numNodes;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> targets;
+
+    uint64_t getNumEdges() const
+    {
+        return this->targets.size();
+    }
+
+    uint32_t getOutDegree(uint32_t vertex) const
+    {
+        return this->offsets[vertex + 1] - this->offsets[vertex];
+    }
+};
+
+// Links of a CsrGraph in the form expected by CompiledNetwork::compile, ids[v] being the id of vertex v
+class CsrGraphLinks {
+public:
+    CsrGraphLinks(CsrGraph const& graphArg, std::vector<PageId> const& idsArg)
+        : graph(graphArg)
+        , ids(idsArg)
+    {
+    }
+
+    size_t getNumLinks(size_t vertex) const
+    {
+        return this->graph.getOutDegree(vertex);
+    }
+
+    std::string_view getLink(size_t vertex, size_t link) const
+    {
+        return this->ids[this->graph.targets[this->graph.offsets[vertex] + link]].getView();
+    }
+
+private:
+    CsrGraph const& graph;
+    std::vector<PageId> const& ids;
+};
+
+// Recursive matrix (R-MAT / stochastic Kronecker) generator of power-law graphs,
+// see Chakrabarti, Zhan, Faloutsos "R-MAT: A Recursive Model for Graph Mining".
+// Every edge descends log2(size) levels of the adjacency matrix choosing one of
+// the quadrants with probabilities a, b, c, d = 1 - a - b - c, randomly perturbed
+// on every level (the same way for all edges) to smooth the degree distribution,
+// see Seshadhri, Pinar, Kolda "An in-depth analysis of stochastic Kronecker graphs".
+// Vertex numbers are scrambled afterwards, so hubs are not clustered around vertex 0.
+// Self-loops and duplicated links are dropped, so the graph has on average a bit
+// less than size * edgeFactor edges and a skewed fraction of dangling nodes.
+// Edges are generated in fixed chunks with their own random streams, so the
+// result depends only on the seed, never on the number of threads. Sampling, counting,
+// placing and deduplicating the edges are all split between threads, but more threads
+// than hardware threads are never used.
+// Vertex v is the page with content std::to_string(v), both as a Network and prepared.
+class RmatNetworkGenerator : public NetworkGenerator {
+public:
+    RmatNetworkGenerator(IdGenerator const& idGeneratorArg, uint32_t edgeFactorArg = 16, uint64_t seedArg = 1,
+        uint32_t numThreadsArg = std::max(1u, std::thread::hardware_concurrency()),
+        double aArg = 0.57, double bArg = 0.19, double cArg = 0.19, double noiseArg = 0.1)
+        : NetworkGenerator(idGeneratorArg)
+        , edgeFactor(edgeFactorArg)
+        , seed(seedArg)
+        , numThreads(numThreadsArg)
+        , a(aArg)
+        , b(bArg)
+        , c(cArg)
+        , noise(noiseArg)
+    {
+        ASSERT(this->numThreads > 0, "Generator needs at least one thread");
+        ASSERT(this->a > 0 and this->b > 0 and this->c > 0 and this->a + this->b + this->c < 1,
+            "Invalid R-MAT probabilities a=" << this->a << ", b=" << this->b << ", c=" << this->c);
+    }
+
+    Network generateNetworkOfSize(uint32_t const size) const
+    {
+        CsrGraph graph = this->generateGraphOfSize(size);
+        std::vector<PageId> ids = this->generateIds(size);
+
+        std::vector<Page> pages(size, Page(""));
+        this->runInParallel(size, MIN_VERTICES_PER_THREAD, [&](uint32_t vertex) {
+            pages[vertex] = this->generatePageFromNum(vertex);
+            for (uint64_t i = graph.offsets[vertex]; i < graph.offsets[vertex + 1]; ++i) {
+                pages[vertex].addLink(ids[graph.targets[i]]);
+            }
+        });
+
+        Network network(this->idGenerator);
+        network.reserve(size);
+        for (auto& page : pages) {
+            network.addPage(std::move(page));
+        }
+        return network;
+    }
+
+    // Compiles the generated graph directly, without building pages, so it can be computed on by
+    // MultiThreadedPageRankComputer like a network it prepared
+    PreparedNetwork generatePreparedNetworkOfSize(uint32_t const size) const
+    {
+        CsrGraph graph = this->generateGraphOfSize(size);
+        std::vector<PageId> ids = this->generateIds(size);
+        CsrGraphLinks links(graph, ids);
+
+        uint32_t numThreads = this->getNumUsedThreads(size, MIN_VERTICES_PER_THREAD);
+        std::vector<WorkMeasurement> measurements(numThreads);
+        std::vector<PageId> compiledIds(ids);
+        if (CompiledNetwork<uint32_t>::canIndex(size, graph.getNumEdges())) {
+            return PreparedNetwork(CompiledNetwork<uint32_t>::compile(std::move(compiledIds), links, numThreads,
+                measurements, false, false));
+        }
+        return PreparedNetwork(CompiledNetwork<uint64_t>::compile(std::move(compiledIds), links, numThreads,
+            measurements, false, false));
+    }
+
+    CsrGraph generateGraphOfSize(uint32_t const size) const
+    {
+        ASSERT(size > 0, "Cannot generate an empty graph");
+        // A single vertex has no edges other than a self-loop, which are never generated
+        if (size < 2) {
+            return CsrGraph { size, std::vector<uint64_t>(size + 1, 0), {} };
+        }
+        uint32_t scale = 0;
+        while ((uint64_t(1) << scale) < size) {
+            ++scale;
+        }
+
+        // Cumulative probabilities of quadrants a, a + b, a + b + c on every level, in units of 2^-32
+        std::vector<std::array<uint32_t, 3>> levels;
+        Random noiseRandom(this->seed);
+        for (uint32_t level = 0; level < scale; ++level) {
+            double levelA = this->a * (1 + this->noise * (2 * noiseRandom.nextDouble() - 1));
+            double levelB = this->b * (1 + this->noise * (2 * noiseRandom.nextDouble() - 1));
+            double levelC = this->c * (1 + this->noise * (2 * noiseRandom.nextDouble() - 1));
+            double levelD = (1 - this->a - this->b - this->c) * (1 + this->noise * (2 * noiseRandom.nextDouble() - 1));
+            double sum = levelA + levelB + levelC + levelD;
+            levels.push_back({ { toThreshold(levelA / sum), toThreshold((levelA + levelB) / sum),
+                toThreshold((levelA + levelB + levelC) / sum) } });
+        }
+
+        uint64_t numEdges = uint64_t(size) * this->edgeFactor;
+        uint64_t numChunks = (numEdges + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> chunks(numChunks);
+        this->runInParallel(numChunks, uint64_t(1), [&](uint64_t chunk) {
+            uint64_t chunkSize = numEdges - chunk * CHUNK_SIZE;
+            if (chunkSize > CHUNK_SIZE) {
+                chunkSize = CHUNK_SIZE;
+            }
+            chunks[chunk] = this->generateChunk(chunk, chunkSize, size, levels);
+        });
+
+        // Every group of consecutive chunks counts the edges of every source in a histogram of its own.
+        // An exclusive prefix sum over sources, and over groups within a source, turns the histograms
+        // into the positions of the edges of every group, which then places them without any locking,
+        // each source getting its edges in the order of the chunks.
+        uint32_t numGroups = this->getNumUsedThreads(numChunks, 1);
+        std::vector<std::vector<uint64_t>> positions(numGroups);
+        this->runInParallel(numGroups, uint32_t(1), [&](uint32_t group) {
+            positions[group].assign(size, 0);
+            for (uint64_t chunk = numChunks * group / numGroups; chunk < numChunks * (group + 1) / numGroups; ++chunk) {
+                for (auto const& edge : chunks[chunk]) {
+                    ++positions[group][edge.first];
+                }
+            }
+        });
+
+        CsrGraph graph { size, std::vector<uint64_t>(size + 1, 0), {} };
+        this->runInParallel(size, MIN_VERTICES_PER_THREAD, [&](uint32_t vertex) {
+            uint64_t degree = 0;
+            for (auto& histogram : positions) {
+                uint64_t count = histogram[vertex];
+                histogram[vertex] = degree;
+                degree += count;
+            }
+            graph.offsets[vertex + 1] = degree;
+        });
+        for (uint32_t vertex = 0; vertex < size; ++vertex) {
+            graph.offsets[vertex + 1] += graph.offsets[vertex];
+        }
+
+        graph.targets.resize(graph.offsets[size]);
+        this->runInParallel(numGroups, uint32_t(1), [&](uint32_t group) {
+            std::vector<uint64_t>& position = positions[group];
+            for (uint64_t chunk = numChunks * group / numGroups; chunk < numChunks * (group + 1) / numGroups; ++chunk) {
+                for (auto const& edge : chunks[chunk]) {
+                    graph.targets[graph.offsets[edge.first] + position[edge.first]++] = edge.second;
+                }
+                std::vector<std::pair<uint32_t, uint32_t>>().swap(chunks[chunk]);
+            }
+            std::vector<uint64_t>().swap(position);
+        });
+
+        // Deduplicate links of every vertex in place, then copy the rows compacted
+        std::vector<uint64_t> rowSizes(size);
+        this->runInParallel(size, MIN_VERTICES_PER_THREAD, [&](uint32_t vertex) {
+            auto rowBegin = graph.targets.begin() + graph.offsets[vertex];
+            auto rowEnd = graph.targets.begin() + graph.offsets[vertex + 1];
+            std::sort(rowBegin, rowEnd);
+            rowSizes[vertex] = std::unique(rowBegin, rowEnd) - rowBegin;
+        });
+
+        std::vector<uint64_t> offsets(size + 1, 0);
+        for (uint32_t vertex = 0; vertex < size; ++vertex) {
+            offsets[vertex + 1] = offsets[vertex] + rowSizes[vertex];
+        }
+        std::vector<uint32_t> targets(offsets[size]);
+        this->runInParallel(size, MIN_VERTICES_PER_THREAD, [&](uint32_t vertex) {
+            auto rowBegin = graph.targets.begin() + graph.offsets[vertex];
+            std::copy(rowBegin, rowBegin + rowSizes[vertex], targets.begin() + offsets[vertex]);
+        });
+        graph.offsets.swap(offsets);
+        graph.targets.swap(targets);
+
+        return graph;
+    }
+
+private:
+    static constexpr uint64_t CHUNK_SIZE = 1 << 16;
+    // Below that a thread costs more to start than its share of the work on vertices
+    static constexpr uint32_t MIN_VERTICES_PER_THREAD = 1 << 14;
+    // Samples per edge of a chunk before it gives up; at least about 1 / 4 of them are
+    // accepted unless the parameters make almost every sample a self-loop
+    static constexpr uint64_t MAX_SAMPLES_PER_EDGE = 64;
+
+    // SplitMix64, small and fast generator good enough for graph generation
+    class Random {
+    public:
+        Random(uint64_t seedArg)
+            : state(seedArg)
+        {
+        }
+
+        uint64_t next()
+        {
+            uint64_t z = (this->state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [0, 1)
+        double nextDouble()
+        {
+            return (this->next() >> 11) * (1.0 / (uint64_t(1) << 53));
+        }
+
+    private:
+        uint64_t state;
+    };
+
+    std::vector<std::pair<uint32_t, uint32_t>> generateChunk(uint64_t chunk, uint64_t chunkSize, uint32_t size,
+        std::vector<std::array<uint32_t, 3>> const& levels) const
+    {
+        uint32_t scale = levels.size();
+        Random random(Random(this->seed ^ (chunk * 0xD1B54A32D192ED03ULL)).next());
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        edges.reserve(chunkSize);
+
+        for (uint64_t sample = 0; edges.size() < chunkSize and sample < chunkSize * MAX_SAMPLES_PER_EDGE; ++sample) {
+            uint64_t source = 0, target = 0;
+            // Every random number chooses quadrants on two levels, 32 bits each.
+            // Quadrants a, b, c, d are (0, 0), (0, 1), (1, 0), (1, 1), so the
+            // target bit is set exactly when an odd number of thresholds is passed.
+            uint64_t bits = 0;
+            for (uint32_t level = 0; level < scale; ++level) {
+                if (level % 2 == 0) {
+                    bits = random.next();
+                }
+                uint32_t quadrant = static_cast<uint32_t>(bits >> (32 * (level % 2)));
+                uint32_t passedA = quadrant >= levels[level][0];
+                uint32_t passedB = quadrant >= levels[level][1];
+                uint32_t passedC = quadrant >= levels[level][2];
+                source = (source << 1) | passedB;
+                target = (target << 1) | (passedA ^ passedB ^ passedC);
+            }
+
+            source = this->scramble(source, scale);
+            target = this->scramble(target, scale);
+            // Sizes which are not a power of two reject vertices outside of the graph
+            if (source < size and target < size and source != target) {
+                edges.emplace_back(source, target);
+            }
+        }
+        return edges;
+    }
+
+    static uint32_t toThreshold(double probability)
+    {
+        return static_cast<uint32_t>(std::min(probability * 4294967296.0, 4294967295.0));
+    }
+
+    // Bijection of [0, 2^scale) mixing the bits of the vertex number
+    uint64_t scramble(uint64_t vertex, uint32_t scale) const
+    {
+        if (scale == 0) {
+            return vertex;
+        }
+        uint64_t mask = (scale == 64) ? ~uint64_t(0) : (uint64_t(1) << scale) - 1;
+        uint64_t key = this->seed | 1;
+        for (uint32_t round = 0; round < 2; ++round) {
+            vertex = (vertex * 0x9E3779B97F4A7C15ULL + key) & mask;
+            vertex ^= vertex >> ((scale + 1) / 2);
+        }
+        return vertex;
+    }
+
+    std::vector<PageId> generateIds(uint32_t size) const
+    {
+        std::vector<PageId> ids(size, PageId(""));
+        this->runInParallel(size, MIN_VERTICES_PER_THREAD, [&](uint32_t vertex) {
+            ids[vertex] = this->idGenerator.generateId(std::to_string(vertex));
+        });
+        return ids;
+    }
+
+    // At most numThreads and the number of hardware threads, and only as many as have minPerThread items each
+    uint32_t getNumUsedThreads(uint64_t count, uint64_t minPerThread) const
+    {
+        uint64_t numHardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        return static_cast<uint32_t>(std::max<uint64_t>(1,
+            std::min({ uint64_t(this->numThreads), numHardwareThreads, count / minPerThread })));
+    }
+
+    // Splits [0, count) into contiguous ranges, one per used thread; a single one runs on the calling thread
+    template <typename Index, typename Function>
+    void runInParallel(Index count, Index minPerThread, Function const& function) const
+    {
+        uint32_t numUsedThreads = this->getNumUsedThreads(count, minPerThread);
+        if (numUsedThreads == 1) {
+            for (Index i = 0; i < count; ++i) {
+                function(i);
+            }
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < numUsedThreads; ++t) {
+            Index begin = static_cast<uint64_t>(count) * t / numUsedThreads;
+            Index end = static_cast<uint64_t>(count) * (t + 1) / numUsedThreads;
+            threads.push_back(std::thread { [&function, begin, end] {
+                for (Index i = begin; i < end; ++i) {
+                    function(i);
+                }
+            } });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    uint32_t edgeFactor;
+    uint64_t seed;
+    uint32_t numThreads;
+    double a;
+    double b;
+    double c;
+    double noise;
+};
+
 class StdinGenerator : public NetworkGenerator {
 public:
-    StdinGenerator(IdGenerator const& idGeneratorArg)
+    StdinGenerator(IdGenerator const& idGeneratorArg, std::istream& inArg = std::cin)
         : NetworkGenerator(idGeneratorArg)
+        , in(inArg)
     {
     }
 
@@ -110,17 +525,18 @@ public:
         Network network(this->idGenerator);
 
         std::string numberOfNodesStr;
-        std::getline(std::cin, numberOfNodesStr);
+        std::getline(this->in, numberOfNodesStr);
         uint32_t numberOfNodes = std::stoul(numberOfNodesStr);
         ASSERT(numberOfNodes == size, "Incorrect size=" << size << ", fromStdin=" << numberOfNodes);
+        network.reserve(numberOfNodes);
 
         for (uint32_t i = 0; i < numberOfNodes; ++i) {
             std::string content;
-            std::getline(std::cin, content);
-            Page page(content);
+            std::getline(this->in, content);
+            Page page(std::move(content));
 
             std::string edges;
-            std::getline(std::cin, edges);
+            std::getline(this->in, edges);
 
             std::stringstream edgesStream(edges);
             std::string edge;
@@ -128,11 +544,14 @@ public:
                 page.addLink(PageId(edge));
             }
             //page.generateId(generator);
-            network.addPage(page);
+            network.addPage(std::move(page));
         }
 
         return network;
     }
+
+private:
+    std::istream& in;
 };
 
 #endif // NETWORK_GENERATOR
@@ -0,0 +1,58 @@
+#ifndef TESTS_LIB_PEAKRESIDENTSET_HPP_
+#define TESTS_LIB_PEAKRESIDENTSET_HPP_
+
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../src/immutable/common.hpp"
+
+// Peak resident set size of a piece of work, which the heap bytes of AllocationCounter
+// do not show: memory kept by the allocator or the arena counts as long as it is resident.
+// ru_maxrss never goes down, so the work runs in a forked child process and only the
+// growth of its peak over what it started with is reported. Memory the parent freed but
+// the allocator kept is returned first, otherwise the child would reuse it unnoticed.
+// The work must not rely on threads of the parent, they do not exist in the child.
+class PeakResidentSet {
+public:
+    template <typename Work>
+    static size_t measureKilobytes(Work const& work)
+    {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+        int fds[2];
+        ASSERT(pipe(fds) == 0, "Cannot create a pipe for the peak resident set");
+        pid_t pid = fork();
+        ASSERT(pid >= 0, "Cannot fork to measure the peak resident set");
+        if (pid == 0) {
+            close(fds[0]);
+            long startKilobytes = getMaxResidentKilobytes();
+            work();
+            long growth = getMaxResidentKilobytes() - startKilobytes;
+            ssize_t written = write(fds[1], &growth, sizeof(growth));
+            _exit(written == sizeof(growth) ? 0 : 1);
+        }
+
+        close(fds[1]);
+        long growth = 0;
+        ssize_t numRead = read(fds[0], &growth, sizeof(growth));
+        close(fds[0]);
+        int status;
+        waitpid(pid, &status, 0);
+        ASSERT(numRead == sizeof(growth) and WIFEXITED(status) and WEXITSTATUS(status) == 0,
+            "Measuring the peak resident set failed");
+        return static_cast<size_t>(growth);
+    }
+
+private:
+    static long getMaxResidentKilobytes()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+};
+
+#endif /* TESTS_LIB_PEAKRESIDENTSET_HPP_ */
@@ -0,0 +1,216 @@
+#ifndef TESTS_LIB_PIPELINEDNETWORKLOADER_HPP_
+#define TESTS_LIB_PIPELINEDNETWORKLOADER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../../src/immutable/network.hpp"
+
+#include "boundedQueue.hpp"
+
+struct PipelineStageStats {
+    std::string name;
+    uint32_t numThreads;
+    size_t numPages;
+    // Summed over the threads of the stage, excludes time spent blocked on queues
+    double busySeconds;
+    double wallSeconds;
+};
+
+struct PipelinedLoadStats {
+    std::vector<PipelineStageStats> stages;
+    std::vector<BoundedQueueStats> queues;
+    double totalSeconds;
+};
+
+inline std::ostream& operator<<(std::ostream& out, PipelinedLoadStats const& stats)
+{
+    out << "Pipelined load took: " << std::setw(9) << stats.totalSeconds << "s" << std::endl;
+    for (auto const& stage : stats.stages) {
+        out << "  stage " << std::setw(7) << stage.name << " [" << stage.numThreads << " threads]: "
+            << stage.numPages << " pages, busy " << stage.busySeconds << "s, wall " << stage.wallSeconds << "s, "
+            << (stage.wallSeconds > 0 ? stage.numPages / stage.wallSeconds : 0.0) << " pages/s" << std::endl;
+    }
+    for (size_t i = 0; i < stats.queues.size(); ++i) {
+        auto const& queue = stats.queues[i];
+        out << "  queue " << stats.stages[i].name << "->" << stats.stages[i + 1].name
+            << ": capacity " << queue.capacity << ", max depth " << queue.maxDepth
+            << ", average depth " << queue.averageDepth << ", full waits " << queue.numFullWaits
+            << ", empty waits " << queue.numEmptyWaits;
+        if (i + 1 < stats.queues.size()) {
+            out << std::endl;
+        }
+    }
+    return out;
+}
+
+// Loads a network in the StdinGenerator format, but instead of doing everything
+// sequentially it runs three overlapping stages connected with bounded queues:
+//   parse   - one thread reading pages from the stream and grouping them into batches,
+//   hash    - a pool of threads generating ids of the pages,
+//   build   - the calling thread adding pages to the network in the order of the input.
+// Pages of the returned network already have their ids generated, so computers
+// start compiling it right away.
+class PipelinedNetworkLoader {
+public:
+    PipelinedNetworkLoader(IdGenerator const& idGeneratorArg, uint32_t numHashThreadsArg,
+        size_t batchSizeArg = 64, size_t queueCapacityArg = 16)
+        : idGenerator(idGeneratorArg)
+        , numHashThreads(numHashThreadsArg)
+        , batchSize(batchSizeArg)
+        , queueCapacity(queueCapacityArg)
+    {
+        ASSERT(this->numHashThreads > 0, "Pipeline needs at least one hashing thread");
+        ASSERT(this->batchSize > 0, "Batch size has to be positive");
+    }
+
+    Network loadNetworkOfSize(std::istream& in, uint32_t const size)
+    {
+        auto loadStart = Clock::now();
+        Network network(this->idGenerator);
+
+        BoundedQueue<Batch> parsedBatches(this->queueCapacity);
+        BoundedQueue<Batch> hashedBatches(this->queueCapacity);
+
+        PipelineStageStats parseStats { "parse", 1, 0, 0, 0 };
+        std::thread parser { [&] {
+            auto start = Clock::now();
+            double waitSeconds = 0;
+
+            std::string numberOfNodesStr;
+            std::getline(in, numberOfNodesStr);
+            uint32_t numberOfNodes = std::stoul(numberOfNodesStr);
+            ASSERT(numberOfNodes == size, "Incorrect size=" << size << ", fromStdin=" << numberOfNodes);
+
+            Batch batch { 0, {} };
+            for (uint32_t i = 0; i < numberOfNodes; ++i) {
+                std::string content;
+                std::getline(in, content);
+                Page page(std::move(content));
+
+                std::string edges;
+                std::getline(in, edges);
+
+                std::stringstream edgesStream(edges);
+                std::string edge;
+                while (edgesStream >> edge) {
+                    page.addLink(PageId(edge));
+                }
+                batch.pages.push_back(std::move(page));
+
+                if (batch.pages.size() == this->batchSize or i + 1 == numberOfNodes) {
+                    size_t nextSequenceNumber = batch.sequenceNumber + 1;
+                    auto pushStart = Clock::now();
+                    parsedBatches.push(std::move(batch));
+                    waitSeconds += secondsSince(pushStart);
+                    batch = Batch { nextSequenceNumber, {} };
+                }
+            }
+            parsedBatches.close();
+
+            parseStats.numPages = numberOfNodes;
+            parseStats.wallSeconds = secondsSince(start);
+            parseStats.busySeconds = parseStats.wallSeconds - waitSeconds;
+        } };
+
+        std::vector<std::thread> hashers;
+        std::vector<double> hasherBusySeconds(this->numHashThreads, 0);
+        std::vector<size_t> hasherNumPages(this->numHashThreads, 0);
+        std::atomic<uint32_t> numRunningHashers(this->numHashThreads);
+        auto hashStart = Clock::now();
+        double hashWallSeconds = 0;
+        for (uint32_t t = 0; t < this->numHashThreads; ++t) {
+            hashers.push_back(std::thread { [&, t] {
+                Batch batch;
+                while (parsedBatches.pop(batch)) {
+                    auto start = Clock::now();
+                    for (auto const& page : batch.pages) {
+                        page.generateId(this->idGenerator);
+                    }
+                    hasherNumPages[t] += batch.pages.size();
+                    hasherBusySeconds[t] += secondsSince(start);
+                    hashedBatches.push(std::move(batch));
+                }
+
+                // The last hashing thread to finish lets the builder know no more batches are coming
+                if (--numRunningHashers == 0) {
+                    hashWallSeconds = secondsSince(hashStart);
+                    hashedBatches.close();
+                }
+            } });
+        }
+
+        // Hashing threads finish batches out of order, the builder restores the order of the input
+        PipelineStageStats buildStats { "build", 1, 0, 0, 0 };
+        std::map<size_t, Batch> pendingBatches;
+        size_t nextSequenceNumber = 0;
+        auto buildStart = Clock::now();
+        Batch batch;
+        while (hashedBatches.pop(batch)) {
+            auto start = Clock::now();
+            size_t sequenceNumber = batch.sequenceNumber;
+            pendingBatches.emplace(sequenceNumber, std::move(batch));
+
+            for (auto iter = pendingBatches.find(nextSequenceNumber); iter != pendingBatches.end();
+                 iter = pendingBatches.find(++nextSequenceNumber)) {
+                for (auto& page : iter->second.pages) {
+                    network.addPage(std::move(page));
+                    ++buildStats.numPages;
+                }
+                pendingBatches.erase(iter);
+            }
+            buildStats.busySeconds += secondsSince(start);
+        }
+        buildStats.wallSeconds = secondsSince(buildStart);
+
+        parser.join();
+        for (auto& hasher : hashers) {
+            hasher.join();
+        }
+        ASSERT(pendingBatches.empty(), "Pipeline lost batches, pending=" << pendingBatches.size());
+
+        PipelineStageStats hashStats { "hash", this->numHashThreads, 0, 0, hashWallSeconds };
+        for (uint32_t t = 0; t < this->numHashThreads; ++t) {
+            hashStats.numPages += hasherNumPages[t];
+            hashStats.busySeconds += hasherBusySeconds[t];
+        }
+
+        this->stats.stages = { parseStats, hashStats, buildStats };
+        this->stats.queues = { parsedBatches.getStats(), hashedBatches.getStats() };
+        this->stats.totalSeconds = secondsSince(loadStart);
+
+        return network;
+    }
+
+    PipelinedLoadStats const& getStats() const
+    {
+        return this->stats;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Batch {
+        size_t sequenceNumber;
+        std::vector<Page> pages;
+    };
+
+    static double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    IdGenerator const& idGenerator;
+    uint32_t numHashThreads;
+    size_t batchSize;
+    size_t queueCapacity;
+
+    PipelinedLoadStats stats;
+};
+
+#endif /* TESTS_LIB_PIPELINEDNETWORKLOADER_HPP_ */
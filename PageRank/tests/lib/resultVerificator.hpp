@@ -25,6 +25,17 @@ public:
         return this->pageRank;
     }
 
+    // Without copying the element, the view is valid as long as it is alive and unchanged
+    static std::string_view getPageIdView(PageIdAndRank const& pageIdAndRank)
+    {
+        return pageIdAndRank.pageId.getView();
+    }
+
+    static PageRank getPageRank(PageIdAndRank const& pageIdAndRank)
+    {
+        return pageIdAndRank.pageRank;
+    }
+
     bool operator<(PageIdAndRankComparable const& other) const
     {
         if (this->pageId == other.pageId) {
@@ -0,0 +1,43 @@
+#ifndef TESTS_LIB_STATSDUMP_HPP_
+#define TESTS_LIB_STATSDUMP_HPP_
+
+#include <cstdlib>
+#include <fstream>
+
+#include "../../src/immutable/common.hpp"
+#include "../../src/pageRankStats.hpp"
+
+// Test binaries dump instrumentation of their computations when the environment
+// variable PAGERANK_STATS_JSON names a file: stats of every computation are
+// appended to it as a single line of JSON. Setting PAGERANK_HW_COUNTERS as well
+// adds hardware counters (where perf_event_open is permitted) to the stats.
+class StatsDump {
+public:
+    static bool isRequested()
+    {
+        return std::getenv(ENVIRONMENT_VARIABLE) != nullptr;
+    }
+
+    static bool wantsHardwareCounters()
+    {
+        return std::getenv(HW_COUNTERS_VARIABLE) != nullptr;
+    }
+
+    static void append(PageRankStats const& stats)
+    {
+        if (not isRequested()) {
+            return;
+        }
+
+        std::ofstream out(std::getenv(ENVIRONMENT_VARIABLE), std::ios::app);
+        ASSERT(out.is_open(), "Cannot open stats file " << std::getenv(ENVIRONMENT_VARIABLE));
+        stats.writeJson(out);
+        out << std::endl;
+    }
+
+private:
+    static constexpr char const* ENVIRONMENT_VARIABLE = "PAGERANK_STATS_JSON";
+    static constexpr char const* HW_COUNTERS_VARIABLE = "PAGERANK_HW_COUNTERS";
+};
+
+#endif /* TESTS_LIB_STATSDUMP_HPP_ */
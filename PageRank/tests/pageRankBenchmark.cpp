@@ -0,0 +1,213 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../src/immutable/common.hpp"
+
+#include "../src/monteCarloPageRankComputer.hpp"
+#include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/singleThreadedPageRankComputer.hpp"
+
+#include "./lib/benchmark.hpp"
+#include "./lib/differentialVerificator.hpp"
+#include "./lib/networkGenerator.hpp"
+#include "./lib/simpleIdGenerator.hpp"
+
+// Usage:
+//   pageRankBenchmark [--families=simple,sparse,rmat,hosts] [--sizes=1000,2000] [--threads=1,2,4,8]
+//                     [--computers=single,multi,multi-two-pass,multi-float,monte-carlo]
+//                     [--warmup=1] [--trials=5] [--format=csv|json] [--output=file] [--counters=0|1]
+//   pageRankBenchmark --compare=baseline,current [--threshold=0.1]
+//   pageRankBenchmark --versus=reference,candidate [--families=...] [--sizes=...] [--threads=4]
+//                     [--max-difference=0.0000001]
+// With --counters=1 instructions per cycle and LLC misses per edge of the rank sweeps
+// are measured with hardware counters (reported as -1 where those are not available).
+// In compare mode the exit code is the number of regressions (capped at 255).
+// Versus mode runs two computers (multi-threaded ones with the first thread count) on the
+// same networks of every family and size, and reports how far apart their results are;
+// the exit code is the number of networks on which some rank differs by max-difference or
+// more, if it is given, or is NaN.
+
+std::vector<std::string> splitList(std::string const& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+template <typename T>
+std::vector<T> splitNumberList(std::string const& list)
+{
+    std::vector<T> numbers;
+    for (auto const& item : splitList(list)) {
+        T number;
+        std::stringstream(item) >> number;
+        numbers.push_back(number);
+    }
+    return numbers;
+}
+
+std::shared_ptr<NetworkGenerator> createNetworkGenerator(std::string const& family, IdGenerator const& idGenerator)
+{
+    if (family == "simple") {
+        return std::make_shared<SimpleNetworkGenerator>(idGenerator);
+    } else if (family == "sparse") {
+        return std::make_shared<NetworkWithoutManyEdgesGenerator>(idGenerator);
+    } else if (family == "rmat") {
+        return std::make_shared<RmatNetworkGenerator>(idGenerator);
+    } else if (family == "hosts") {
+        return std::make_shared<HostNetworkGenerator>(idGenerator);
+    }
+    FAIL("Unknown graph family: " << family);
+}
+
+std::vector<std::pair<std::shared_ptr<PageRankComputer>, uint32_t>> createComputers(
+    std::vector<std::string> const& computerNames, std::vector<uint32_t> const& threadCounts)
+{
+    std::vector<std::pair<std::shared_ptr<PageRankComputer>, uint32_t>> computers;
+    for (auto const& name : computerNames) {
+        if (name == "single") {
+            computers.emplace_back(std::make_shared<SingleThreadedPageRankComputer>(), 1);
+            continue;
+        }
+
+        ASSERT(name == "multi" or name == "multi-two-pass" or name == "multi-float" or name == "monte-carlo",
+            "Unknown computer: " << name);
+        for (uint32_t numThreads : threadCounts) {
+            if (name == "monte-carlo") {
+                computers.emplace_back(std::make_shared<MonteCarloPageRankComputer>(numThreads, 16), numThreads);
+                continue;
+            }
+            computers.emplace_back(std::make_shared<MultiThreadedPageRankComputer>(numThreads,
+                name != "multi-two-pass", name == "multi-float"), numThreads);
+        }
+    }
+    return computers;
+}
+
+int main(int argc, char** argv)
+{
+    std::map<std::string, std::string> options = {
+        { "families", "simple,sparse" },
+        { "sizes", "1000,2000" },
+        { "threads", "1,2,4,8" },
+        { "computers", "single,multi" },
+        { "warmup", "1" },
+        { "trials", "5" },
+        { "format", "csv" },
+        { "output", "" },
+        { "compare", "" },
+        { "threshold", "0.1" },
+        { "counters", "0" },
+        { "versus", "" },
+        { "max-difference", "" },
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string argument(argv[i]);
+        size_t separator = argument.find('=');
+        ASSERT(argument.compare(0, 2, "--") == 0 and separator != std::string::npos, "Invalid argument: " << argument);
+
+        std::string name = argument.substr(2, separator - 2);
+        ASSERT(options.count(name) > 0, "Unknown option: " << name);
+        options[name] = argument.substr(separator + 1);
+    }
+
+    if (not options["compare"].empty()) {
+        std::vector<std::string> files = splitList(options["compare"]);
+        ASSERT(files.size() == 2, "Compare mode needs exactly two result files");
+
+        double threshold;
+        std::stringstream(options["threshold"]) >> threshold;
+        uint32_t numRegressions = BenchmarkComparator::compare(
+            BenchmarkResultFile::read(files[0]), BenchmarkResultFile::read(files[1]), threshold, std::cout);
+        std::cout << numRegressions << " regression(s) above " << 100.0 * threshold << "%" << std::endl;
+        return std::min(numRegressions, 255u);
+    }
+
+    SimpleIdGenerator idGenerator("2000f1ffa5ce95d0f1e1893598e6aeeb2c214c85a88e3569d62c2dccd06a8725");
+
+    if (not options["versus"].empty()) {
+        std::vector<std::string> names = splitList(options["versus"]);
+        ASSERT(names.size() == 2, "Versus mode needs exactly two computers");
+        std::vector<uint32_t> threadCounts = { splitNumberList<uint32_t>(options["threads"]).front() };
+        auto reference = createComputers({ names[0] }, threadCounts).front();
+        auto candidate = createComputers({ names[1] }, threadCounts).front();
+        double maxDifference = std::numeric_limits<double>::infinity();
+        if (not options["max-difference"].empty()) {
+            std::stringstream(options["max-difference"]) >> maxDifference;
+        }
+
+        uint32_t numDifferent = 0;
+        for (auto const& family : splitList(options["families"])) {
+            auto networkGenerator = createNetworkGenerator(family, idGenerator);
+            for (uint32_t numNodes : splitNumberList<uint32_t>(options["sizes"])) {
+                Network network = networkGenerator->generateNetworkOfSize(numNodes);
+                PerformanceTimer referenceTimer;
+                auto referenceResult = reference.first->computeForNetwork(network, 0.85, 100, 0.0000001);
+                double referenceSeconds = referenceTimer.getSeconds();
+                PerformanceTimer candidateTimer;
+                auto candidateResult = candidate.first->computeForNetwork(network, 0.85, 100, 0.0000001);
+                double candidateSeconds = candidateTimer.getSeconds();
+
+                ResultDifference difference = DifferentialVerificator::compare(referenceResult, candidateResult,
+                    threadCounts.front());
+                bool different = not (difference.lInf < maxDifference);
+                numDifferent += different;
+                std::cout << "Versus [" << family << "/" << numNodes << "]: " << reference.first->getName() << " "
+                          << referenceSeconds << "s, " << candidate.first->getName() << " " << candidateSeconds
+                          << "s, " << difference << (different ? ", DIFFERENT" : "") << std::endl;
+            }
+        }
+        return std::min(numDifferent, 255u);
+    }
+
+    uint32_t numWarmupRuns, numTrials;
+    std::stringstream(options["warmup"]) >> numWarmupRuns;
+    std::stringstream(options["trials"]) >> numTrials;
+    BenchmarkRunner runner(numWarmupRuns, numTrials, options["counters"] == "1");
+
+    auto computers = createComputers(splitList(options["computers"]), splitNumberList<uint32_t>(options["threads"]));
+
+    std::vector<BenchmarkResult> results;
+    for (auto const& family : splitList(options["families"])) {
+        auto networkGenerator = createNetworkGenerator(family, idGenerator);
+        for (uint32_t numNodes : splitNumberList<uint32_t>(options["sizes"])) {
+            for (auto const& computer : computers) {
+                results.push_back(runner.run(family, *networkGenerator, numNodes, *computer.first, computer.second));
+
+                auto const& result = results.back();
+                std::cerr << "Benchmark [" << result.getKey() << "]: median " << result.medianSeconds
+                          << "s, p90 " << result.p90Seconds << "s, " << result.numIterations << " iterations, "
+                          << result.edgesPerSecond << " edges/s";
+                if (result.instructionsPerCycle >= 0) {
+                    std::cerr << ", IPC " << result.instructionsPerCycle;
+                }
+                if (result.llcMissesPerEdge >= 0) {
+                    std::cerr << ", " << result.llcMissesPerEdge << " LLC misses/edge";
+                }
+                std::cerr << std::endl;
+            }
+        }
+    }
+
+    std::ofstream outputFile;
+    if (not options["output"].empty()) {
+        outputFile.open(options["output"]);
+        ASSERT(outputFile.is_open(), "Cannot open output file " << options["output"]);
+    }
+    std::ostream& out = options["output"].empty() ? std::cout : outputFile;
+
+    ASSERT(options["format"] == "csv" or options["format"] == "json", "Unknown format: " << options["format"]);
+    if (options["format"] == "csv") {
+        BenchmarkResultFile::writeCsv(out, results);
+    } else {
+        BenchmarkResultFile::writeJson(out, results);
+    }
+
+    return 0;
+}
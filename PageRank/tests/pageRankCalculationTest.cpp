@@ -1,11 +1,18 @@
+#include <cmath>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "../src/immutable/common.hpp"
 #include "../src/immutable/pageIdAndRank.hpp"
+#include "../src/batchPageRankComputer.hpp"
+#include "../src/monteCarloPageRankComputer.hpp"
 #include "../src/multiThreadedPageRankComputer.hpp"
 #include "../src/singleThreadedPageRankComputer.hpp"
 
+#include "./lib/differentialVerificator.hpp"
 #include "./lib/networkGenerator.hpp"
 #include "./lib/resultVerificator.hpp"
 #include "./lib/simpleIdGenerator.hpp"
@@ -19,6 +26,155 @@ struct TestScenario {
     std::vector<PageRank> expectedResult;
 };
 
+// Ranks of big networks are too small for ResultVerificator, they are compared more tightly here
+void verifyAgainstReference(std::vector<PageIdAndRank> const& reference, std::vector<PageIdAndRank> const& result)
+{
+    DifferentialVerificator::verify(reference, result, 0.0000001, 4);
+}
+
+void testScenarios(PageRankComputer const& computer, std::vector<TestScenario> const& scenarios, NetworkGenerator const& networkGenerator)
+{
+    for (auto scenario : scenarios) {
+        std::cout << "Starting scenario with numberOfNodes=" << scenario.numberOfNodes << ", alpha=" << scenario.alpha << std::endl;
+        auto result = computer.computeForNetwork(
+            networkGenerator.generateNetworkOfSize(scenario.numberOfNodes),
+            scenario.alpha,
+            scenario.iterations,
+            scenario.tolerance);
+        ResultVerificator::verifyResults(result, scenario.expectedResult, networkGenerator);
+        std::cout << "Scenario finished with successed" << std::endl;
+    }
+}
+
+// Prepared once per network, computed for every scenario on it and also twice in a row
+void testPreparedScenarios(MultiThreadedPageRankComputer const& computer, std::vector<TestScenario> const& scenarios, NetworkGenerator const& networkGenerator)
+{
+    std::map<uint32_t, PreparedNetwork> preparedNetworks;
+    for (auto scenario : scenarios) {
+        std::cout << "Starting prepared scenario with numberOfNodes=" << scenario.numberOfNodes << ", alpha=" << scenario.alpha << std::endl;
+        if (preparedNetworks.count(scenario.numberOfNodes) == 0) {
+            Network network = networkGenerator.generateNetworkOfSize(scenario.numberOfNodes);
+            preparedNetworks.emplace(scenario.numberOfNodes, computer.prepare(network));
+            // Ids already generated by prepare are reused
+            ResultVerificator::verifyResults(
+                computer.computeForNetwork(network, scenario.alpha, scenario.iterations, scenario.tolerance),
+                scenario.expectedResult, networkGenerator);
+        }
+        PreparedNetwork const& prepared = preparedNetworks.at(scenario.numberOfNodes);
+        for (int i = 0; i < 2; ++i) {
+            auto result = computer.computeForNetwork(prepared, scenario.alpha, scenario.iterations, scenario.tolerance);
+            ResultVerificator::verifyResults(result, scenario.expectedResult, networkGenerator);
+        }
+        std::cout << "Scenario finished with successed" << std::endl;
+    }
+}
+
+// Every scenario many times over in a single batch, networks are spread over the workers in any order
+void testBatch(uint32_t numThreads, std::vector<TestScenario> const& scenarios, NetworkGenerator const& networkGenerator)
+{
+    std::cout << "Starting batch with numThreads=" << numThreads << std::endl;
+    std::vector<Network> networks;
+    std::vector<TestScenario const*> networkScenarios;
+    for (int i = 0; i < 20; ++i) {
+        for (auto const& scenario : scenarios) {
+            if (scenario.alpha == 0.85) {
+                networks.push_back(networkGenerator.generateNetworkOfSize(scenario.numberOfNodes));
+                networkScenarios.push_back(&scenario);
+            }
+        }
+    }
+    BatchPageRankComputer computer { numThreads };
+    for (int batch = 0; batch < 2; ++batch) {
+        std::vector<PageRankResult> results = computer.computeForNetworks(networks, 0.85, 100, 0.0000001);
+        ASSERT(results.size() == networks.size(), "Invalid number of results=" << results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            ASSERT(results[i].converged, "Network " << i << " did not converge");
+            ResultVerificator::verifyResults(results[i].ranks, networkScenarios[i]->expectedResult, networkGenerator);
+        }
+    }
+    std::vector<PageRankResult> results = computer.computeForNetworks(networks, 0.85, 2, 0.0000001);
+    for (auto const& result : results) {
+        ASSERT(not result.converged and result.numIterations == 2, "Two iterations should not be enough");
+    }
+    std::cout << "Scenario finished with successed" << std::endl;
+}
+
+// Every estimate within a few standard errors of the exact rank
+void testMonteCarloScenarios(uint32_t numThreads, std::vector<TestScenario> const& scenarios, NetworkGenerator const& networkGenerator)
+{
+    for (auto scenario : scenarios) {
+        std::cout << "Starting Monte Carlo scenario with numberOfNodes=" << scenario.numberOfNodes << ", alpha=" << scenario.alpha
+                  << ", numThreads=" << numThreads << std::endl;
+        uint32_t walksPerPage = 400000 / scenario.numberOfNodes;
+        MonteCarloPageRankComputer computer { numThreads, walksPerPage };
+        auto result = computer.computeForNetwork(networkGenerator.generateNetworkOfSize(scenario.numberOfNodes),
+            scenario.alpha, scenario.iterations, scenario.tolerance);
+        ASSERT(result.size() == scenario.numberOfNodes, "Invalid number of results=" << result.size());
+        std::unordered_map<PageId, PageRank, PageIdHash> estimates;
+        for (PageIdAndRankComparable estimate : result) {
+            estimates.emplace(estimate.getPageId(), estimate.getPageRank());
+        }
+        for (uint32_t i = 0; i < scenario.numberOfNodes; ++i) {
+            PageRank expected = scenario.expectedResult[i];
+            PageRank estimate = estimates.at(networkGenerator.generatePageFromNumWithGeneratedId(i).getId());
+            double bound = MonteCarloPageRankComputer::getStandardErrorBound(scenario.alpha, scenario.numberOfNodes, walksPerPage, expected);
+            ASSERT(std::abs(estimate - expected) < 5 * bound, "Estimate " << estimate << " too far from " << expected);
+        }
+        std::cout << "Scenario finished with successed" << std::endl;
+    }
+}
+
+// Networks too big for the expected ranks to be written down, compared with the single-threaded computer
+void testAgainstReference(NetworkGenerator const& generator)
+{
+    auto reference = SingleThreadedPageRankComputer {}.computeForNetwork(generator.generateNetworkOfSize(20000), 0.85, 100, 0.0000001);
+    std::vector<std::shared_ptr<PageRankComputer>> computers = {
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 1 }),
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 4 }),
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 1, false }),
+        std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 4, false }),
+        std::shared_ptr<PageRankComputer>(new BatchPageRankComputer { 2 }),
+    };
+    for (auto computer : computers) {
+        std::cout << "Starting reference comparison with " << computer->getName() << std::endl;
+        verifyAgainstReference(reference, computer->computeForNetwork(generator.generateNetworkOfSize(20000), 0.85, 100, 0.0000001));
+        std::cout << "Scenario finished with successed" << std::endl;
+    }
+
+    // Few walks only keep the sum of errors within its bound, which holds in expectation
+    for (uint32_t walksPerPage : { 4, 16 }) {
+        MonteCarloPageRankComputer computer { 3, walksPerPage, 7 };
+        std::cout << "Starting reference comparison with " << computer.getName() << std::endl;
+        PageRankResult result = computer.computeWithControl(generator.generateNetworkOfSize(20000), 0.85, 100, 0.0000001, nullptr);
+        double distance = DifferentialVerificator::compare(reference, result.ranks, 4).l1;
+        ASSERT(distance < 2 * result.residual, "Error " << distance << " far above its bound " << result.residual);
+        std::cout << "Scenario finished with successed" << std::endl;
+    }
+}
+
+// Too small for the recursive quadrants, a single page cannot have any links
+void testTinyRmatNetwork(uint32_t size, RmatNetworkGenerator const& rmatNetworkGenerator)
+{
+    std::cout << "Starting tiny R-MAT network with numberOfNodes=" << size << std::endl;
+    Network network = rmatNetworkGenerator.generateNetworkOfSize(size);
+    ASSERT(size > 1 or network.getPages()[0].getLinks().empty(), "Single page with links");
+    auto reference = SingleThreadedPageRankComputer {}.computeForNetwork(network, 0.85, 100, 0.0000001);
+    verifyAgainstReference(reference, MultiThreadedPageRankComputer { 2 }.computeForNetwork(network, 0.85, 100, 0.0000001));
+    std::cout << "Scenario finished with successed" << std::endl;
+}
+
+// Every thread places its edges at offsets counted beforehand, so the graph does not depend on their number
+void testRmatGraphDoesNotDependOnNumThreads(IdGenerator const& idGenerator)
+{
+    std::cout << "Starting R-MAT generation with different numbers of threads" << std::endl;
+    CsrGraph graph = RmatNetworkGenerator { idGenerator, 16, 1, 1 }.generateGraphOfSize(200000);
+    for (uint32_t numThreads : { 2, 3, 8 }) {
+        CsrGraph other = RmatNetworkGenerator { idGenerator, 16, 1, numThreads }.generateGraphOfSize(200000);
+        ASSERT(other.offsets == graph.offsets and other.targets == graph.targets, "Graph differs with numThreads=" << numThreads);
+    }
+    std::cout << "Scenario finished with successed" << std::endl;
+}
+
 int main()
 {
     std::vector<TestScenario> scenarios = {
@@ -37,23 +193,41 @@ int main()
             std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 7 }),
             std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 8 }),
             std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 9 }),
+            std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 4, false }),
+            std::shared_ptr<PageRankComputer>(new MultiThreadedPageRankComputer { 3, true, true }),
+            std::shared_ptr<PageRankComputer>(new BatchPageRankComputer { 1 }),
+            std::shared_ptr<PageRankComputer>(new BatchPageRankComputer { 4 }),
     };
 
     SimpleIdGenerator idGenerator("b7628d82a284526971095162ba34be8bc05c6e06b9face83b46c2813f7f2157b");
     SimpleNetworkGenerator networkGenerator(idGenerator);
     for (auto computer : computersToTest) {
+        testScenarios(*computer, scenarios, networkGenerator);
+    }
 
-        for (auto scenario : scenarios) {
-             std::cout << "Starting scenario with numberOfNodes=" << scenario.numberOfNodes << ", alpha=" << scenario.alpha << std::endl;
-            auto result = computer->computeForNetwork(
-                networkGenerator.generateNetworkOfSize(scenario.numberOfNodes),
-                scenario.alpha,
-                scenario.iterations,
-                scenario.tolerance);
-            ResultVerificator::verifyResults(result, scenario.expectedResult, networkGenerator);
-             std::cout << "Scenario finished with successed" << std::endl;
-        }
+    std::vector<std::shared_ptr<MultiThreadedPageRankComputer>> preparingComputers = {
+            std::make_shared<MultiThreadedPageRankComputer>(1),
+            std::make_shared<MultiThreadedPageRankComputer>(4),
+            std::make_shared<MultiThreadedPageRankComputer>(3, true, true),
+    };
+    for (auto computer : preparingComputers) {
+        testPreparedScenarios(*computer, scenarios, networkGenerator);
+    }
+
+    for (uint32_t numThreads : { 1, 3 }) {
+        testBatch(numThreads, scenarios, networkGenerator);
+        testMonteCarloScenarios(numThreads, scenarios, networkGenerator);
+    }
+
+    // Mostly isolated pages and pages without in-links, which the multi-threaded computer does not iterate over
+    NetworkWithoutManyEdgesGenerator sparseNetworkGenerator(idGenerator);
+    RmatNetworkGenerator rmatNetworkGenerator(idGenerator);
+    testAgainstReference(sparseNetworkGenerator);
+    testAgainstReference(rmatNetworkGenerator);
+    for (uint32_t size : { 1, 2, 3 }) {
+        testTinyRmatNetwork(size, rmatNetworkGenerator);
     }
+    testRmatGraphDoesNotDependOnNumThreads(idGenerator);
 
     return 0;
 }
@@ -1,33 +1,265 @@
 #include "../src/immutable/common.hpp"
 #include "../src/immutable/pageIdAndRank.hpp"
 
+#include "../src/batchPageRankComputer.hpp"
+#include "../src/monteCarloPageRankComputer.hpp"
 #include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/pageRankObservable.hpp"
 #include "../src/singleThreadedPageRankComputer.hpp"
 
+#include "./lib/allocationCounter.hpp"
+#include "./lib/arenaNetworkLoader.hpp"
+#include "./lib/differentialVerificator.hpp"
 #include "./lib/networkGenerator.hpp"
+#include "./lib/peakResidentSet.hpp"
 #include "./lib/performanceTimer.hpp"
 #include "./lib/resultVerificator.hpp"
 #include "./lib/simpleIdGenerator.hpp"
+#include "./lib/statsDump.hpp"
 
-void pageRankComputationWithNumNodes(uint32_t num, PageRankComputer const& computer, NetworkGenerator const& networkGenerator)
+void pageRankComputationWithNumNodes(uint32_t num, PageRankComputer&& computer, NetworkGenerator const& networkGenerator)
 {
     Network network = networkGenerator.generateNetworkOfSize(num);
+    PageRankStats stats(StatsDump::wantsHardwareCounters());
+    if (StatsDump::isRequested()) {
+        PageRankObservable::setObserverOf(computer, &stats);
+    }
     PerformanceTimer timer;
     std::vector<PageIdAndRank> result = computer.computeForNetwork(network, 0.85, 100, 0.0000001);
     timer.printTimeDifference("PageRank Performance Test [" + std::to_string(num) + " nodes, " + computer.getName() + "]");
 
     ASSERT(result.size() == network.getSize(), "Invalid result size=" << result.size());
+    StatsDump::append(stats);
+}
+
+// Generates the same graph with every number of threads, reporting the speedup over the first one
+void rmatGeneratorThroughput(uint32_t num, uint32_t edgeFactor, std::vector<uint32_t> const& threadCounts, IdGenerator const& idGenerator)
+{
+    double firstSeconds = 0;
+    for (uint32_t numThreads : threadCounts) {
+        RmatNetworkGenerator generator(idGenerator, edgeFactor, 1, numThreads);
+        PerformanceTimer timer;
+        CsrGraph graph = generator.generateGraphOfSize(num);
+        double seconds = timer.getSeconds();
+        if (firstSeconds == 0) {
+            firstSeconds = seconds;
+        }
+
+        uint32_t numDanglingNodes = 0;
+        uint32_t maxOutDegree = 0;
+        for (uint32_t vertex = 0; vertex < num; ++vertex) {
+            numDanglingNodes += graph.getOutDegree(vertex) == 0;
+            maxOutDegree = std::max(maxOutDegree, graph.getOutDegree(vertex));
+        }
+
+        std::cout << "R-MAT generator [" << num << " nodes, " << graph.getNumEdges() << " edges, " << numThreads
+                  << " threads, " << std::thread::hardware_concurrency() << " hardware threads] took: " << std::setw(9) << seconds << "s, " << graph.getNumEdges() / seconds
+                  << " edges/s, speedup " << firstSeconds / seconds << "x, dangling " << 100.0 * numDanglingNodes / num << "%, max out-degree " << maxOutDegree << std::endl;
+    }
+}
+
+// Generated graph compiled directly into a prepared network, without building pages first
+void rmatPreparedComputation(uint32_t num, uint32_t numThreads, IdGenerator const& idGenerator)
+{
+    RmatNetworkGenerator generator(idGenerator, 16, 1, numThreads);
+    PerformanceTimer generatorTimer;
+    PreparedNetwork prepared = generator.generatePreparedNetworkOfSize(num);
+    double generatorSeconds = generatorTimer.getSeconds();
+
+    PerformanceTimer timer;
+    PageRankResult result = MultiThreadedPageRankComputer { numThreads }.computeWithControl(prepared, 0.85, 100, 0.0000001, nullptr);
+    double seconds = timer.getSeconds();
+    ASSERT(result.ranks.size() == num and result.converged, "Invalid result of the prepared R-MAT network");
+
+    std::cout << "R-MAT prepared network [" << num << " nodes, " << prepared.getNumEdges() << " core edges]: generated in "
+              << generatorSeconds << "s, " << result.numIterations << " iterations in " << seconds << "s" << std::endl;
+}
+
+void fusedIterationSaving(uint32_t num, uint32_t numThreads, NetworkGenerator const& networkGenerator)
+{
+    double twoPassSeconds, fusedSeconds;
+    {
+        Network network = networkGenerator.generateNetworkOfSize(num);
+        PerformanceTimer timer;
+        MultiThreadedPageRankComputer { numThreads, false }.computeForNetwork(network, 0.85, 100, 0.0000001);
+        twoPassSeconds = timer.getSeconds();
+    }
+    {
+        Network network = networkGenerator.generateNetworkOfSize(num);
+        PerformanceTimer timer;
+        MultiThreadedPageRankComputer { numThreads, true }.computeForNetwork(network, 0.85, 100, 0.0000001);
+        fusedSeconds = timer.getSeconds();
+    }
+
+    std::cout << "Fused iteration saving [" << num << " nodes, " << numThreads << " threads]: two-pass "
+              << twoPassSeconds << "s, fused " << fusedSeconds << "s, saved "
+              << 100.0 * (1.0 - fusedSeconds / twoPassSeconds) << "%" << std::endl;
+}
+
+// Pages without in-links are left out of the iterations, only the rest is swept every time
+void iteratedCore(uint32_t num, NetworkGenerator const& networkGenerator)
+{
+    Network network = networkGenerator.generateNetworkOfSize(num);
+    MultiThreadedPageRankComputer computer { 4 };
+    PreparedNetwork prepared = computer.prepare(network);
+    PerformanceTimer timer;
+    computer.computeForNetwork(prepared, 0.85, 100, 0.0000001);
+    double seconds = timer.getSeconds();
+
+    std::cout << "Iterated core [" << num << " nodes]: " << prepared.getNumCoreVertices() << " vertices, "
+              << prepared.getNumEdges() << " edges, iterations took " << seconds << "s" << std::endl;
+}
+
+// Many small networks, one after another with all threads on each, and in a batch with a network per thread
+void batchThroughput(uint32_t numNetworks, uint32_t num, uint32_t numThreads, NetworkGenerator const& networkGenerator)
+{
+    std::vector<Network> networks;
+    for (uint32_t i = 0; i < numNetworks; ++i) {
+        networks.push_back(networkGenerator.generateNetworkOfSize(num));
+    }
+    // Ids are generated by the first computation, both measurements start with them ready
+    BatchPageRankComputer batchComputer { numThreads };
+    batchComputer.computeForNetworks(networks, 0.85, 100, 0.0000001);
+
+    MultiThreadedPageRankComputer computer { numThreads };
+    PerformanceTimer timer;
+    for (auto const& network : networks) {
+        computer.computeForNetwork(network, 0.85, 100, 0.0000001);
+    }
+    double seconds = timer.getSeconds();
+
+    PerformanceTimer batchTimer;
+    batchComputer.computeForNetworks(networks, 0.85, 100, 0.0000001);
+    double batchSeconds = batchTimer.getSeconds();
+
+    std::cout << "Batch throughput [" << numNetworks << " networks of " << num << " nodes, " << numThreads
+              << " threads]: one by one " << numNetworks / seconds << " networks/s, batch "
+              << numNetworks / batchSeconds << " networks/s" << std::endl;
+}
+
+// Time and error of random walks against the exact ranks, for more and more walks per page
+void monteCarloAccuracy(uint32_t num, uint32_t numThreads, std::vector<uint32_t> const& walksPerPageSteps,
+    NetworkGenerator const& networkGenerator)
+{
+    Network network = networkGenerator.generateNetworkOfSize(num);
+    MultiThreadedPageRankComputer exactComputer { numThreads };
+    exactComputer.computeForNetwork(network, 0.85, 100, 0.0000001);
+    PerformanceTimer exactTimer;
+    std::vector<PageIdAndRank> exact = exactComputer.computeForNetwork(network, 0.85, 100, 0.0000001);
+    double exactSeconds = exactTimer.getSeconds();
+
+    for (uint32_t walksPerPage : walksPerPageSteps) {
+        MonteCarloPageRankComputer computer { numThreads, walksPerPage };
+        PerformanceTimer timer;
+        PageRankResult result = computer.computeWithControl(network, 0.85, 100, 0.0000001, nullptr);
+        double seconds = timer.getSeconds();
+
+        ResultDifference difference = DifferentialVerificator::compare(exact, result.ranks, numThreads);
+        std::cout << "Monte Carlo accuracy [" << num << " nodes, " << walksPerPage << " walks per page]: " << seconds
+                  << "s (exact " << exactSeconds << "s, bound " << result.residual << "), " << difference << std::endl;
+        ASSERT(difference.l1 < 2 * result.residual, "Error " << difference.l1 << " far above its bound " << result.residual);
+    }
+}
+
+// Verifying a result against a reference by ordered sets of ids, and by the differential verificator
+void verificationThroughput(uint32_t num, uint32_t numThreads, NetworkGenerator const& networkGenerator)
+{
+    Network network = networkGenerator.generateNetworkOfSize(num);
+    PerformanceTimer computationTimer;
+    std::vector<PageIdAndRank> reference = MultiThreadedPageRankComputer { numThreads }.computeForNetwork(network, 0.85, 100, 0.0000001);
+    double computationSeconds = computationTimer.getSeconds();
+    std::vector<PageIdAndRank> result = MultiThreadedPageRankComputer { numThreads, false }.computeForNetwork(network, 0.85, 100, 0.0000001);
+
+    PerformanceTimer setTimer;
+    ResultVerificator::verifyResults(std::set<PageIdAndRankComparable>(reference.begin(), reference.end()),
+        std::set<PageIdAndRankComparable>(result.begin(), result.end()));
+    double setSeconds = setTimer.getSeconds();
+    PerformanceTimer differentialTimer;
+    DifferentialVerificator::verify(reference, result, 0.0000001, numThreads);
+    double differentialSeconds = differentialTimer.getSeconds();
+
+    // The join uses at most the hardware threads, and runs sequentially on a single one
+    std::cout << "Verification throughput [" << num << " nodes, " << numThreads << " threads, "
+              << std::thread::hardware_concurrency() << " hardware threads]: computation "
+              << computationSeconds << "s, ordered sets " << setSeconds << "s, differential " << differentialSeconds
+              << "s" << std::endl;
+}
+
+// Loads the same scenario into an ArenaNetwork and into a Network, both computations must agree.
+// Peak resident set growth of every load is measured in a separate process.
+void networkLoadingFootprint(uint32_t num, NetworkGenerator const& networkGenerator, IdGenerator const& idGenerator)
+{
+    std::string scenario;
+    {
+        Network network = networkGenerator.generateNetworkOfSize(num);
+        std::ostringstream out;
+        out << num << "\n";
+        for (auto const& page : network.getPages()) {
+            out << page.getContent() << "\n";
+            for (auto const& link : page.getLinks()) {
+                out << link << " ";
+            }
+            out << "\n";
+        }
+        scenario = out.str();
+    }
+
+    // Streams are filled before forking, so the copies of the scenario are not part of the growth
+    size_t arenaPeakKilobytes, pagesPeakKilobytes;
+    {
+        std::istringstream in(scenario);
+        arenaPeakKilobytes = PeakResidentSet::measureKilobytes([&] { ArenaNetworkLoader::loadNetworkOfSize(in, num, idGenerator); });
+    }
+    {
+        std::istringstream in(scenario);
+        pagesPeakKilobytes = PeakResidentSet::measureKilobytes([&] { StdinGenerator(idGenerator, in).generateNetworkOfSize(num); });
+    }
+
+    std::vector<PageIdAndRank> arenaResult;
+    {
+        std::istringstream in(scenario);
+        size_t numAllocations = AllocationCounter::getNumAllocations();
+        size_t heapBytes = AllocationCounter::getHeapBytes();
+        PerformanceTimer timer;
+        ArenaNetwork network = ArenaNetworkLoader::loadNetworkOfSize(in, num, idGenerator);
+        double seconds = timer.getSeconds();
+        std::cout << "Network loading [" << num << " nodes, " << network.getTotalNumLinks() << " links, arena]: "
+                  << seconds << "s, " << AllocationCounter::getNumAllocations() - numAllocations << " allocations, "
+                  << (AllocationCounter::getHeapBytes() - heapBytes) / 1024 << " kB of heap, "
+                  << arenaPeakKilobytes << " kB peak resident set growth" << std::endl;
+        arenaResult = MultiThreadedPageRankComputer { 4 }.computeForNetwork(network, 0.85, 100, 0.0000001);
+    }
+
+    {
+        std::istringstream in(scenario);
+        size_t numAllocations = AllocationCounter::getNumAllocations();
+        size_t heapBytes = AllocationCounter::getHeapBytes();
+        PerformanceTimer timer;
+        Network network = StdinGenerator(idGenerator, in).generateNetworkOfSize(num);
+        double seconds = timer.getSeconds();
+        std::cout << "Network loading [" << num << " nodes, pages]: " << seconds << "s, "
+                  << AllocationCounter::getNumAllocations() - numAllocations << " allocations, "
+                  << (AllocationCounter::getHeapBytes() - heapBytes) / 1024 << " kB of heap, "
+                  << pagesPeakKilobytes << " kB peak resident set growth" << std::endl;
+
+        std::vector<PageIdAndRank> result = MultiThreadedPageRankComputer { 4 }.computeForNetwork(network, 0.85, 100, 0.0000001);
+        ASSERT(result.size() == arenaResult.size(), "Invalid result size=" << result.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            PageIdAndRankComparable expected(result[i]), actual(arenaResult[i]);
+            ASSERT(expected.getPageId() == actual.getPageId() and expected.getPageRank() == actual.getPageRank(),
+                "Arena network result differs: " << arenaResult[i] << " != " << result[i]);
+        }
+    }
 }
 
 int main()
 {
-    SingleThreadedPageRankComputer computer;
     SimpleIdGenerator simpleIdGenerator("2000f1ffa5ce95d0f1e1893598e6aeeb2c214c85a88e3569d62c2dccd06a8725");
     SimpleNetworkGenerator simpleNetworkGenerator(simpleIdGenerator);
 
-    pageRankComputationWithNumNodes(100, computer, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(1000, computer, simpleNetworkGenerator);
-    pageRankComputationWithNumNodes(2000, computer, simpleNetworkGenerator);
+    pageRankComputationWithNumNodes(100, SingleThreadedPageRankComputer {}, simpleNetworkGenerator);
+    pageRankComputationWithNumNodes(1000, SingleThreadedPageRankComputer {}, simpleNetworkGenerator);
+    pageRankComputationWithNumNodes(2000, SingleThreadedPageRankComputer {}, simpleNetworkGenerator);
 
     pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 1 }, simpleNetworkGenerator);
     pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 2 }, simpleNetworkGenerator);
@@ -36,11 +268,33 @@ int main()
     pageRankComputationWithNumNodes(2000, MultiThreadedPageRankComputer { 8 }, simpleNetworkGenerator);
 
     NetworkWithoutManyEdgesGenerator networkWithoutEdgesGenerator(simpleIdGenerator);
-    pageRankComputationWithNumNodes(500000, computer, networkWithoutEdgesGenerator);
+    pageRankComputationWithNumNodes(500000, SingleThreadedPageRankComputer {}, networkWithoutEdgesGenerator);
     pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 1 }, networkWithoutEdgesGenerator);
     pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 2 }, networkWithoutEdgesGenerator);
     pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 3 }, networkWithoutEdgesGenerator);
     pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 4 }, networkWithoutEdgesGenerator);
     pageRankComputationWithNumNodes(500000, MultiThreadedPageRankComputer { 8 }, networkWithoutEdgesGenerator);
+
+    RmatNetworkGenerator rmatNetworkGenerator(simpleIdGenerator, 16);
+    pageRankComputationWithNumNodes(20000, SingleThreadedPageRankComputer {}, rmatNetworkGenerator);
+    pageRankComputationWithNumNodes(20000, MultiThreadedPageRankComputer { 4 }, rmatNetworkGenerator);
+
+    rmatGeneratorThroughput(1000000, 16, { 1, 2, 4, 8 }, simpleIdGenerator);
+    rmatPreparedComputation(200000, 4, simpleIdGenerator);
+
+    fusedIterationSaving(2000, 4, simpleNetworkGenerator);
+    fusedIterationSaving(500000, 4, networkWithoutEdgesGenerator);
+
+    iteratedCore(500000, networkWithoutEdgesGenerator);
+
+    batchThroughput(2000, 100, 4, simpleNetworkGenerator);
+    batchThroughput(2000, 100, 4, rmatNetworkGenerator);
+
+    monteCarloAccuracy(20000, 4, { 1, 4, 16, 64 }, rmatNetworkGenerator);
+    monteCarloAccuracy(500000, 4, { 1, 4 }, networkWithoutEdgesGenerator);
+
+    verificationThroughput(500000, 4, RmatNetworkGenerator(simpleIdGenerator, 4));
+
+    networkLoadingFootprint(500000, RmatNetworkGenerator(simpleIdGenerator, 4), simpleIdGenerator);
     return 0;
 }
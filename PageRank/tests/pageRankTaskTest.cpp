@@ -0,0 +1,110 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "../src/immutable/common.hpp"
+
+#include "../src/batchPageRankComputer.hpp"
+#include "../src/multiThreadedPageRankComputer.hpp"
+#include "../src/pageRankTask.hpp"
+#include "../src/singleThreadedPageRankComputer.hpp"
+
+#include "./lib/networkGenerator.hpp"
+#include "./lib/resultVerificator.hpp"
+#include "./lib/simpleIdGenerator.hpp"
+
+template <typename Computer>
+void testConvergedResultMatchesComputeForNetwork(Computer const& computer, NetworkGenerator const& generator)
+{
+    Network network = generator.generateNetworkOfSize(1000);
+    PageRankTask task = PageRankTask::start(computer, network, 0.85, 100, 0.0000001);
+    PageRankResult const& result = task.get();
+    ASSERT(result.converged and not result.cancelled, "Computation did not converge, residual=" << result.residual);
+    ASSERT(result.residual < 0.0000001, "Converged with residual=" << result.residual);
+    ASSERT(task.isFinished(), "Finished task reports it is running");
+
+    std::set<PageIdAndRankComparable> expected, actual;
+    for (auto const& pageIdAndRank : computer.computeForNetwork(generator.generateNetworkOfSize(1000), 0.85, 100, 0.0000001)) {
+        expected.insert(pageIdAndRank);
+    }
+    for (auto const& pageIdAndRank : result.ranks) {
+        actual.insert(pageIdAndRank);
+    }
+    ResultVerificator::verifyResults(expected, actual);
+}
+
+template <typename Computer>
+void testNotConvergedResultIsReturned(Computer const& computer, NetworkGenerator const& generator)
+{
+    Network network = generator.generateNetworkOfSize(1000);
+    PageRankResult result = computer.computeWithControl(network, 0.85, 2, 0.0000001, nullptr);
+    ASSERT(not result.converged and not result.cancelled, "Two iterations should not be enough");
+    ASSERT(result.numIterations == 2, "Unexpected number of iterations=" << result.numIterations);
+    ASSERT(result.residual >= 0.0000001, "Unexpected residual=" << result.residual);
+    ASSERT(result.ranks.size() == network.getSize(), "Invalid result size=" << result.ranks.size());
+}
+
+template <typename Computer>
+void testSnapshotsAndCancellation(Computer const& computer, NetworkGenerator const& generator)
+{
+    // Zero tolerance never converges, only cancellation stops the computation
+    Network network = generator.generateNetworkOfSize(2000);
+    PageRankTask task = PageRankTask::start(computer, network, 0.85, 1000000000, 0);
+
+    PageRankSnapshot first = task.getSnapshot();
+    PageRankSnapshot second = task.getSnapshot();
+    ASSERT(first.ranks.size() == network.getSize() and second.ranks.size() == network.getSize(),
+        "Invalid snapshot sizes=" << first.ranks.size() << ", " << second.ranks.size());
+    ASSERT(first.numIterations > 0 and second.numIterations > first.numIterations,
+        "Snapshots not taken after iterations " << first.numIterations << ", " << second.numIterations);
+    ASSERT(task.getProgress().numIterations >= second.numIterations, "Progress behind the snapshot");
+    ASSERT(not task.waitFor(std::chrono::milliseconds(10)), "Computation stopped by itself");
+
+    task.cancel();
+    PageRankResult const& result = task.get();
+    ASSERT(result.cancelled and not result.converged, "Computation not cancelled");
+    ASSERT(result.numIterations >= second.numIterations, "Iterations lost, numIterations=" << result.numIterations);
+    ASSERT(result.ranks.size() == network.getSize(), "Invalid result size=" << result.ranks.size());
+
+    PageRankSnapshot last = task.getSnapshot();
+    ASSERT(last.numIterations == result.numIterations, "Snapshot of finished task is not its result");
+}
+
+template <typename Computer>
+void testCancelledBeforeFirstIteration(Computer const& computer, NetworkGenerator const& generator)
+{
+    Network network = generator.generateNetworkOfSize(100);
+    PageRankControl control;
+    control.cancel();
+    PageRankResult result = computer.computeWithControl(network, 0.85, 100, 0.0000001, &control);
+    ASSERT(result.cancelled and result.numIterations == 0, "Cancelled computation iterated " << result.numIterations);
+    ASSERT(result.ranks.size() == network.getSize(), "Invalid result size=" << result.ranks.size());
+
+    PageRankSnapshot snapshot;
+    ASSERT(not control.takeSnapshot(snapshot), "Snapshot of a finished computation");
+}
+
+// Computers which can be controlled, so also run by a PageRankTask
+template <typename Computer>
+void testComputer(Computer const& computer, NetworkGenerator const& generator)
+{
+    testConvergedResultMatchesComputeForNetwork(computer, generator);
+    testNotConvergedResultIsReturned(computer, generator);
+    testSnapshotsAndCancellation(computer, generator);
+    testCancelledBeforeFirstIteration(computer, generator);
+    std::cout << "PageRank task test [" << computer.getName() << "] passed" << std::endl;
+}
+
+int main()
+{
+    SimpleIdGenerator idGenerator("b7628d82a284526971095162ba34be8bc05c6e06b9face83b46c2813f7f2157b");
+    SimpleNetworkGenerator networkGenerator(idGenerator);
+
+    testComputer(SingleThreadedPageRankComputer {}, networkGenerator);
+    testComputer(MultiThreadedPageRankComputer { 1 }, networkGenerator);
+    testComputer(MultiThreadedPageRankComputer { 4 }, networkGenerator);
+    testComputer(MultiThreadedPageRankComputer { 3, false }, networkGenerator);
+    testComputer(BatchPageRankComputer { 2 }, networkGenerator);
+
+    return 0;
+}